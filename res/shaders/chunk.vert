@@ -1,5 +1,10 @@
 #version 430
-layout(location = 0) in uint a_vertex;
+
+/* One record per quad, see encode_quad() in meshing.c. Each quad is drawn as 6 vertices, so the
+ * quad and corner are derived from gl_VertexID. */
+layout(std430, binding = 0) readonly buffer Quads {
+    uvec2 quads[];
+};
 
 uniform mat4 u_view_proj;
 uniform vec3 u_position;
@@ -18,17 +23,41 @@ const vec3 NORMAL_TABLE[6] = vec3[](
     vec3( 0, -1,  0),    /* DIR_NEGATIVE_Y */
     vec3( 0,  0, -1)     /* DIR_NEGATIVE_Z */
 );
+
+/* Must match FACE_VERTICES in meshing.c. */
+const vec3 FACE_VERTICES[24] = vec3[](
+    vec3(1, 0, 0), vec3(1, 1, 0), vec3(1, 1, 1), vec3(1, 0, 1),    /* DIR_POSITIVE_X */
+    vec3(1, 1, 1), vec3(1, 1, 0), vec3(0, 1, 0), vec3(0, 1, 1),    /* DIR_POSITIVE_Y */
+    vec3(0, 0, 1), vec3(1, 0, 1), vec3(1, 1, 1), vec3(0, 1, 1),    /* DIR_POSITIVE_Z */
+    vec3(0, 0, 1), vec3(0, 1, 1), vec3(0, 1, 0), vec3(0, 0, 0),    /* DIR_NEGATIVE_X */
+    vec3(0, 0, 1), vec3(0, 0, 0), vec3(1, 0, 0), vec3(1, 0, 1),    /* DIR_NEGATIVE_Y */
+    vec3(0, 1, 0), vec3(1, 1, 0), vec3(1, 0, 0), vec3(0, 0, 0)     /* DIR_NEGATIVE_Z */
+);
+
+/* Two triangles per quad. */
+const uint CORNER_PATTERN[6] = uint[](0u, 1u, 3u, 1u, 2u, 3u);
 /* clang-format on */
 
 void main() {
-    uint x = (a_vertex >> 26) & 0x3Fu;
-    uint y = (a_vertex >> 20) & 0x3Fu;
-    uint z = (a_vertex >> 14) & 0x3Fu;
-    uint direction = (a_vertex >> 11) & 0x7u;
-    uint ao = (a_vertex >> 9) & 0x3u;
-    uint texture_id = a_vertex & 0x1FFu;
-
-    vec3 position = vec3(x, y, z) + u_position;
+    uvec2 quad = quads[gl_VertexID / 6];
+    uint corner = CORNER_PATTERN[gl_VertexID % 6];
+
+    uint x = quad.x & 0x3Fu;
+    uint y = (quad.x >> 6) & 0x3Fu;
+    uint z = (quad.x >> 12) & 0x3Fu;
+    uint width = ((quad.x >> 18) & 0x1Fu) + 1u;
+    uint height = ((quad.x >> 23) & 0x1Fu) + 1u;
+    uint direction = (quad.x >> 28) & 0x7u;
+    uint ao = (quad.y >> (corner * 2u)) & 0x3u;
+    uint texture_id = (quad.y >> 8) & 0x1FFu;
+
+    /* The quad is stretched along the two axes perpendicular to its normal. */
+    uint axis = direction % 3u;
+    vec3 size = vec3(1.0);
+    size[(axis + 1u) % 3u] = float(width);
+    size[(axis + 2u) % 3u] = float(height);
+
+    vec3 position = vec3(x, y, z) + FACE_VERTICES[direction * 4u + corner] * size + u_position;
     v_normal = NORMAL_TABLE[direction];
     v_uv = vec3(dot(v_normal.xzy, position.zxx), position.y + v_normal.y * position.z, texture_id);
     v_color = clamp(0.05 + vec3(ao / 4.0), 0.0, 1.0);
@@ -0,0 +1,1352 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "render/meshing.h"
+#include "utils/arena.h"
+#include "utils/range_allocator.h"
+#include "utils/thread.h"
+#include "utils/timer.h"
+#include "world/chunk.h"
+#include "world/region.h"
+#include "world/terrain.h"
+#include "world/world.h"
+
+/* Headless microbenchmarks for the world and meshing code. Results are written to stdout as CSV,
+ * one row per benchmark and pattern. All inputs are generated from fixed seeds, so runs on
+ * different machines measure exactly the same work. */
+
+#define DEFAULT_MESH_ITERATIONS 200
+#define DEFAULT_GATHER_ITERATIONS 2000
+#define DEFAULT_GENERATE_ITERATIONS 200
+#define DEFAULT_RANGE_ALLOC_ITERATIONS 2000
+#define DEFAULT_POP_DIRTY_ITERATIONS 5
+#define DEFAULT_REGION_ITERATIONS 20
+#define DEFAULT_STREAM_ITERATIONS 5
+#define DEFAULT_JOURNAL_ITERATIONS 5
+#define DEFAULT_FILL_ITERATIONS 20
+#define DEFAULT_LAYOUT_ITERATIONS 5
+#define DEFAULT_NOISE_ITERATIONS 20
+#define DEFAULT_WORLD_GENERATION_ITERATIONS 3
+
+/* Region files and the journal written by the save benchmarks, relative to the working directory.
+ * They're deleted once the benchmarks finish. */
+#define BENCH_WORLD_DIRECTORY "quadcraft_bench_world"
+
+/* The chunk that the pattern benchmarks mesh. Its neighbors are loaded too, so the padding of the
+ * meshing data comes from the same pattern. A horizontal radius of 2 is the smallest circle that
+ * covers the diagonal neighbors. */
+static const iVec3 BENCH_CHUNK_COORD = {1, 1, 1};
+#define PATTERN_LOAD_RADIUS 2
+#define PATTERN_VERTICAL_LOAD_RADIUS 1
+
+/* Chunks from y = 0 up to this are generated, which spans the terrain surface. */
+#define GENERATE_COLUMN_HEIGHT 8
+
+/* Sizes of the worlds whose chunks are drained through the dirty queue. The streaming world holds
+ * about 29,000 chunks, and its player moves a chunk every POP_DIRTY_MOVE_INTERVAL pops, so the
+ * queue is re-keyed while it drains. */
+#define POP_DIRTY_LOAD_RADIUS 12
+#define POP_DIRTY_VERTICAL_LOAD_RADIUS 3
+#define POP_DIRTY_STREAMING_LOAD_RADIUS 32
+#define POP_DIRTY_STREAMING_VERTICAL_LOAD_RADIUS 4
+#define POP_DIRTY_MOVE_INTERVAL 256
+
+/* The streamed world walks STREAM_STEPS chunks along x per iteration, with a memory budget of
+ * twice what its loaded chunks use, so out of range chunks are cached and then evicted. */
+#define STREAM_LOAD_RADIUS 8
+#define STREAM_VERTICAL_LOAD_RADIUS 3
+#define STREAM_STEPS 64
+
+/* Edits made per iteration of the journal benchmarks. Grouped edits are committed by world updates,
+ * one every JOURNAL_EDITS_PER_UPDATE edits, as sustained editing in the game would. Unbatched
+ * edits are each committed on their own, which is what the grouping saves. */
+#define JOURNAL_GROUPED_EDITS 20000
+#define JOURNAL_UNBATCHED_EDITS 200
+#define JOURNAL_EDITS_PER_UPDATE 64
+
+/* The edit benchmarks fill a FILL_BOX_SIZE^3 box that straddles chunk borders on every axis, in a
+ * world loaded FILL_LOAD_RADIUS chunks around it. */
+#define FILL_BOX_SIZE 64
+#define FILL_LOAD_RADIUS 3
+#define FILL_VERTICAL_LOAD_RADIUS 3
+
+/* The chunk layout benchmarks gather and list every chunk of the streaming world, whose map is far
+ * larger than the caches. */
+#define LAYOUT_LOAD_RADIUS POP_DIRTY_STREAMING_LOAD_RADIUS
+#define LAYOUT_VERTICAL_LOAD_RADIUS POP_DIRTY_STREAMING_VERTICAL_LOAD_RADIUS
+
+/* The noise benchmarks sample a NOISE_GRID_SIZE^2 or ^3 grid with the terrain's octaves, spaced
+ * so the samples fall at varied positions within the noise cells. --verify compares every kernel
+ * against the scalar one on the same grids. */
+#define NOISE_GRID_SIZE 64
+#define NOISE_GRID_SPACING 0.37f
+#define NOISE_OCTAVE_COUNT 5
+
+/* The world generation benchmarks load a world of terrain from nothing, as the game does at
+ * startup, either on the main thread or on generation workers. */
+#define WORLD_GENERATION_LOAD_RADIUS 8
+#define WORLD_GENERATION_VERTICAL_LOAD_RADIUS 3
+
+/* Number of random chunks checked by --verify, on top of the patterns. */
+#define VERIFY_RANDOM_CHUNKS 64
+
+/* Number of GENERATE_COLUMN_HEIGHT chunk tall columns of terrain checked by --verify, and of
+ * blocks in each chunk also checked against generate_block(). */
+#define VERIFY_TERRAIN_COLUMNS 16
+#define VERIFY_TERRAIN_BLOCKS 64
+
+#define RANGE_ALLOC_LIVE_RANGES 256
+#define RANGE_ALLOC_MAX_SIZE 4096
+
+typedef enum Pattern {
+    PATTERN_EMPTY,
+    PATTERN_SOLID,
+    PATTERN_FLAT,
+    PATTERN_CHECKERBOARD,
+    PATTERN_NOISE,
+
+    PATTERN_COUNT,
+} Pattern;
+
+static const char *PATTERN_NAMES[PATTERN_COUNT] = {
+    [PATTERN_EMPTY] = "empty",
+    [PATTERN_SOLID] = "solid",
+    [PATTERN_FLAT] = "flat",
+    [PATTERN_CHECKERBOARD] = "checkerboard",
+    [PATTERN_NOISE] = "noise",
+};
+
+typedef struct Bench_Result {
+    const char *benchmark;
+    const char *pattern;
+    size_t iterations;
+
+    /* Each iteration may perform several operations; the times are per operation. */
+    size_t ops_per_iteration;
+    uint64_t total_ns;
+    uint64_t min_iteration_ns;
+
+    /* Zero when the benchmark doesn't work on voxels. */
+    size_t voxels_per_op;
+
+    /* Only reported by the meshing benchmarks. */
+    bool has_mesh_stats;
+    size_t quads_per_op;
+    size_t allocated_bytes_per_op;
+
+    /* Only reported by the region benchmarks. Throughput is measured in uncompressed bytes. */
+    bool has_io_stats;
+    size_t uncompressed_bytes_per_op;
+    size_t stored_bytes_per_op;
+} Bench_Result;
+
+static struct {
+    size_t iterations_override;
+    const char *filter;
+    bool verify;
+
+    World world;
+    bool has_world;
+    Pattern pattern;
+
+    Meshing_Data meshing_data;
+    Arena arena;
+
+    Region_Storage region_storage;
+    bool has_region_storage;
+} bench;
+
+/* A small integer hash, so that noise patterns are identical on every platform. */
+static uint32_t hash_u32(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+    return value;
+}
+
+static uint32_t hash_position(iVec3 position) {
+    uint32_t hash = hash_u32((uint32_t)position.x);
+    hash = hash_u32(hash ^ (uint32_t)position.y);
+    hash = hash_u32(hash ^ (uint32_t)position.z);
+    return hash;
+}
+
+static Block_Type get_pattern_block(Pattern pattern, iVec3 position) {
+    switch (pattern) {
+    case PATTERN_EMPTY:
+        return BLOCK_AIR;
+    case PATTERN_SOLID:
+        return BLOCK_DIRT;
+    case PATTERN_FLAT: {
+        /* The surface runs through the middle of the benchmarked chunk. */
+        int surface = BENCH_CHUNK_COORD.y * CHUNK_SIZE + CHUNK_SIZE / 2;
+        if (position.y < surface) {
+            return BLOCK_DIRT;
+        } else if (position.y == surface) {
+            return BLOCK_GRASS;
+        }
+        return BLOCK_AIR;
+    }
+    case PATTERN_CHECKERBOARD:
+        /* Worst case for the mesher: every solid block has all 6 faces exposed. */
+        return ((position.x + position.y + position.z) & 1) ? BLOCK_DIRT : BLOCK_AIR;
+    case PATTERN_NOISE:
+        return (Block_Type)(hash_position(position) % BLOCK_TYPE_COUNT);
+    default:
+        assert(false && "Unknown pattern");
+        return BLOCK_AIR;
+    }
+}
+
+static void generate_pattern_chunk(Chunk *chunk, iVec3 chunk_coord) {
+    iVec3 chunk_origin = ivec3_scale(chunk_coord, CHUNK_SIZE);
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                iVec3 local_position = {x, y, z};
+                iVec3 position = ivec3_add(chunk_origin, local_position);
+                chunk_set_block_unsafe(chunk, local_position,
+                                       get_pattern_block(bench.pattern, position));
+            }
+        }
+    }
+}
+
+static void generate_empty_chunk(Chunk *chunk, iVec3 chunk_coord) {
+    (void)chunk;
+    (void)chunk_coord;
+}
+
+/* Replaces the world with a fully loaded one of the given size around the center. */
+static void reset_world(int load_radius, int vertical_load_radius, Chunk_Generate_Fn generate,
+                        iVec3 center) {
+    if (bench.has_world) {
+        world_destroy(&bench.world);
+    }
+
+    if (!world_create(&bench.world, load_radius, vertical_load_radius, generate, NULL)) {
+        fprintf(stderr, "world_create() failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bench.has_world = true;
+    bench.world.max_loads_per_update = SIZE_MAX;
+    world_update_loaded_chunks(&bench.world, center);
+}
+
+/* Fills the benchmarked chunk and its neighbors with the pattern. */
+static void fill_pattern(Pattern pattern) {
+    bench.pattern = pattern;
+    reset_world(PATTERN_LOAD_RADIUS, PATTERN_VERTICAL_LOAD_RADIUS, generate_pattern_chunk,
+                BENCH_CHUNK_COORD);
+
+    world_get_meshing_data(&bench.world, BENCH_CHUNK_COORD, &bench.meshing_data);
+}
+
+static bool is_selected(const char *benchmark, const char *pattern) {
+    if (!bench.filter) {
+        return true;
+    }
+
+    char name[128];
+    snprintf(name, sizeof(name), "%s/%s", benchmark, pattern);
+    return strstr(name, bench.filter) != NULL;
+}
+
+static size_t get_iterations(size_t default_iterations) {
+    return bench.iterations_override > 0 ? bench.iterations_override : default_iterations;
+}
+
+static void record_iteration(Bench_Result *result, uint64_t elapsed_ns) {
+    result->total_ns += elapsed_ns;
+    if (result->iterations == 0 || elapsed_ns < result->min_iteration_ns) {
+        result->min_iteration_ns = elapsed_ns;
+    }
+
+    result->iterations++;
+}
+
+static void print_csv_header(void) {
+    printf(
+        "benchmark,pattern,iterations,mean_ns_per_op,min_ns_per_op,ns_per_voxel,quads_per_chunk,"
+        "allocated_bytes_per_op,mb_per_second,compression_ratio\n");
+}
+
+static void print_result(const Bench_Result *result) {
+    assert(result->iterations > 0);
+    assert(result->ops_per_iteration > 0);
+
+    double op_count = (double)result->iterations * (double)result->ops_per_iteration;
+    double mean_ns = (double)result->total_ns / op_count;
+    double min_ns = (double)result->min_iteration_ns / (double)result->ops_per_iteration;
+
+    printf("%s,%s,%zu,%.1f,%.1f,", result->benchmark, result->pattern, result->iterations, mean_ns,
+           min_ns);
+
+    if (result->voxels_per_op > 0) {
+        printf("%.3f,", mean_ns / (double)result->voxels_per_op);
+    } else {
+        printf(",");
+    }
+
+    if (result->has_mesh_stats) {
+        printf("%zu,%zu,", result->quads_per_op, result->allocated_bytes_per_op);
+    } else {
+        printf(",,");
+    }
+
+    if (result->has_io_stats) {
+        /* Bytes per nanosecond is GB/s. */
+        double mb_per_second = (double)result->uncompressed_bytes_per_op / mean_ns * 1000.0;
+        double compression_ratio =
+            (double)result->uncompressed_bytes_per_op / (double)result->stored_bytes_per_op;
+        printf("%.1f,%.1f\n", mb_per_second, compression_ratio);
+    } else {
+        printf(",\n");
+    }
+    fflush(stdout);
+}
+
+static void bench_mesh(Meshing_Mode mode, Pattern pattern) {
+    const char *benchmark = mode == MESHING_MODE_GREEDY ? "mesh_greedy" : "mesh_naive";
+    if (!is_selected(benchmark, PATTERN_NAMES[pattern])) {
+        return;
+    }
+
+    fill_pattern(pattern);
+
+    Bench_Result result = {
+        .benchmark = benchmark,
+        .pattern = PATTERN_NAMES[pattern],
+        .ops_per_iteration = 1,
+        .voxels_per_op = CHUNK_VOLUME,
+        .has_mesh_stats = true,
+    };
+
+    /* Warm up the caches and the arena's committed memory before measuring. */
+    Chunk_Mesh mesh;
+    mesh_chunk_with_mode(&bench.meshing_data, mode, &mesh, &bench.arena);
+    arena_reset(&bench.arena);
+
+    size_t iterations = get_iterations(DEFAULT_MESH_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start_ns = get_time_ns();
+        mesh_chunk_with_mode(&bench.meshing_data, mode, &mesh, &bench.arena);
+        record_iteration(&result, get_time_ns() - start_ns);
+
+        result.quads_per_op = mesh.quad_count;
+        result.allocated_bytes_per_op = bench.arena.offset;
+        arena_reset(&bench.arena);
+    }
+
+    print_result(&result);
+}
+
+static void bench_gather(Pattern pattern) {
+    if (!is_selected("gather", PATTERN_NAMES[pattern])) {
+        return;
+    }
+
+    fill_pattern(pattern);
+
+    Bench_Result result = {
+        .benchmark = "gather",
+        .pattern = PATTERN_NAMES[pattern],
+        .ops_per_iteration = 1,
+        .voxels_per_op = MESHING_DATA_VOLUME,
+    };
+
+    size_t iterations = get_iterations(DEFAULT_GATHER_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start_ns = get_time_ns();
+        world_get_meshing_data(&bench.world, BENCH_CHUNK_COORD, &bench.meshing_data);
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+}
+
+/* What submitting a mesh job costs the main thread: snapshotting the chunk and its neighbors.
+ * The snapshots are released right away, as a worker would after gathering from them. */
+static void bench_snapshot(Pattern pattern) {
+    if (!is_selected("snapshot_neighborhood", PATTERN_NAMES[pattern])) {
+        return;
+    }
+
+    fill_pattern(pattern);
+
+    Bench_Result result = {
+        .benchmark = "snapshot_neighborhood",
+        .pattern = PATTERN_NAMES[pattern],
+        .ops_per_iteration = 1,
+    };
+
+    Chunk_Neighborhood neighborhood;
+    size_t iterations = get_iterations(DEFAULT_GATHER_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start_ns = get_time_ns();
+        world_snapshot_neighborhood(&bench.world, BENCH_CHUNK_COORD, &neighborhood);
+        world_release_neighborhood(&neighborhood);
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+}
+
+typedef struct Noise_Samples {
+    float *x;
+    float *y;
+    float *z;
+    float *out;
+    size_t count;
+} Noise_Samples;
+
+/* A grid of sample positions around the origin, so negative coordinates are covered. */
+static Noise_Samples create_noise_samples(int dimensions) {
+    size_t count = NOISE_GRID_SIZE * NOISE_GRID_SIZE;
+    if (dimensions == 3) {
+        count *= NOISE_GRID_SIZE;
+    }
+
+    Noise_Samples samples = {
+        .x = malloc(sizeof(float) * count),
+        .y = malloc(sizeof(float) * count),
+        .z = malloc(sizeof(float) * count),
+        .out = malloc(sizeof(float) * count),
+        .count = count,
+    };
+
+    if (!samples.x || !samples.y || !samples.z || !samples.out) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        int x = (int)(i % NOISE_GRID_SIZE) - NOISE_GRID_SIZE / 2;
+        int y = (int)(i / NOISE_GRID_SIZE % NOISE_GRID_SIZE) - NOISE_GRID_SIZE / 2;
+        int z = (int)(i / (NOISE_GRID_SIZE * NOISE_GRID_SIZE)) - NOISE_GRID_SIZE / 2;
+        samples.x[i] = (float)x * NOISE_GRID_SPACING;
+        samples.y[i] = (float)y * NOISE_GRID_SPACING;
+        samples.z[i] = (float)z * NOISE_GRID_SPACING;
+    }
+
+    return samples;
+}
+
+static void destroy_noise_samples(Noise_Samples *samples) {
+    free(samples->x);
+    free(samples->y);
+    free(samples->z);
+    free(samples->out);
+}
+
+static void evaluate_noise(const Noise_Settings *settings, Noise_Kernel kernel, int dimensions,
+                           Noise_Samples *samples) {
+    if (dimensions == 3) {
+        noise_fractal_3d(settings, kernel, samples->x, samples->y, samples->z, samples->out,
+                         samples->count);
+    } else {
+        noise_fractal_2d(settings, kernel, samples->x, samples->y, samples->out, samples->count);
+    }
+}
+
+static const Noise_Settings BENCH_NOISE_SETTINGS = {
+    .seed = TERRAIN_DEFAULT_SEED,
+    .octave_count = NOISE_OCTAVE_COUNT,
+    .frequency = 1.0f,
+    .lacunarity = 2.0f,
+    .gain = 0.5f,
+};
+
+/* Samples per second is 10^9 divided by the time per op. */
+static void bench_noise(int dimensions, Noise_Kernel kernel) {
+    const char *benchmark = dimensions == 3 ? "noise_3d" : "noise_2d";
+    const char *pattern = noise_kernel_name(kernel);
+    if (!is_selected(benchmark, pattern)) {
+        return;
+    }
+
+    if (!noise_is_kernel_supported(kernel)) {
+        fprintf(stderr, "Skipping %s/%s, which this CPU doesn't support\n", benchmark, pattern);
+        return;
+    }
+
+    Noise_Samples samples = create_noise_samples(dimensions);
+
+    Bench_Result result = {
+        .benchmark = benchmark,
+        .pattern = pattern,
+        .ops_per_iteration = samples.count,
+    };
+
+    size_t iterations = get_iterations(DEFAULT_NOISE_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start_ns = get_time_ns();
+        evaluate_noise(&BENCH_NOISE_SETTINGS, kernel, dimensions, &samples);
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+    destroy_noise_samples(&samples);
+}
+
+/* Times a chunk generator on terrain with or without caves. */
+static void bench_generate(const char *pattern, Chunk_Generate_Fn generate, bool has_caves) {
+    if (!is_selected("generate_chunk", pattern)) {
+        return;
+    }
+
+    terrain_init(TERRAIN_DEFAULT_SEED, noise_get_fastest_kernel(), has_caves);
+
+    Bench_Result result = {
+        .benchmark = "generate_chunk",
+        .pattern = pattern,
+        .ops_per_iteration = 1,
+        .voxels_per_op = CHUNK_VOLUME,
+    };
+
+    Chunk *chunk = malloc(sizeof(Chunk));
+    if (!chunk) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Cycle through a column of chunks so the surface, solid and empty chunks are all included. */
+    size_t iterations = get_iterations(DEFAULT_GENERATE_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        iVec3 chunk_coord = {(int)(i / GENERATE_COLUMN_HEIGHT), (int)(i % GENERATE_COLUMN_HEIGHT),
+                             0};
+        chunk_init(chunk, chunk_coord);
+
+        uint64_t start_ns = get_time_ns();
+        generate(chunk, chunk_coord);
+        record_iteration(&result, get_time_ns() - start_ns);
+
+        chunk_destroy(chunk);
+    }
+
+    free(chunk);
+    terrain_init(TERRAIN_DEFAULT_SEED, noise_get_fastest_kernel(), true);
+    print_result(&result);
+}
+
+static void bench_range_alloc(void) {
+    if (!is_selected("range_alloc", "churn")) {
+        return;
+    }
+
+    Bench_Result result = {
+        .benchmark = "range_alloc",
+        .pattern = "churn",
+        .ops_per_iteration = RANGE_ALLOC_LIVE_RANGES,
+    };
+
+    static Range_Allocator allocator;
+    range_allocator_create(&allocator, (size_t)RANGE_ALLOC_LIVE_RANGES * RANGE_ALLOC_MAX_SIZE * 2);
+
+    Range ranges[RANGE_ALLOC_LIVE_RANGES];
+    uint32_t seed = 1;
+    for (size_t i = 0; i < RANGE_ALLOC_LIVE_RANGES; i++) {
+        seed = hash_u32(seed);
+        if (!range_alloc(&allocator, 1 + seed % RANGE_ALLOC_MAX_SIZE, &ranges[i])) {
+            fprintf(stderr, "range_alloc() failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Like remeshing: each operation frees a random live range and allocates one of a new size. */
+    size_t iterations = get_iterations(DEFAULT_RANGE_ALLOC_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start_ns = get_time_ns();
+        for (size_t j = 0; j < RANGE_ALLOC_LIVE_RANGES; j++) {
+            seed = hash_u32(seed);
+            size_t index = seed % RANGE_ALLOC_LIVE_RANGES;
+
+            range_free(&allocator, ranges[index]);
+            if (!range_alloc(&allocator, 1 + (seed >> 16) % RANGE_ALLOC_MAX_SIZE,
+                             &ranges[index])) {
+                fprintf(stderr, "range_alloc() failed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    range_allocator_destroy(&allocator);
+    print_result(&result);
+}
+
+static void bench_pop_dirty(const char *pattern, int load_radius, int vertical_load_radius,
+                            bool is_player_moving) {
+    if (!is_selected("world_pop_dirty_chunk", pattern)) {
+        return;
+    }
+
+    iVec3 center = {0, 0, 0};
+    reset_world(load_radius, vertical_load_radius, generate_empty_chunk, center);
+
+    Bench_Result result = {
+        .benchmark = "world_pop_dirty_chunk",
+        .pattern = pattern,
+        .ops_per_iteration = bench.world.chunks.count,
+    };
+
+    /* Loading pushed every chunk already. */
+    size_t iterations = get_iterations(DEFAULT_POP_DIRTY_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        if (i > 0) {
+            for (size_t j = 0; j < bench.world.chunks.capacity; j++) {
+                Chunk *chunk = bench.world.chunks.entries[j].chunk;
+                if (chunk) {
+                    world_push_dirty_chunk(&bench.world, chunk);
+                }
+            }
+        }
+
+        iVec3 player_position = center;
+        size_t pop_count = 0;
+
+        uint64_t start_ns = get_time_ns();
+        while (world_pop_dirty_chunk(&bench.world, player_position)) {
+            pop_count++;
+            if (is_player_moving && pop_count % POP_DIRTY_MOVE_INTERVAL == 0) {
+                player_position.x++;
+            }
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+}
+
+static void bench_stream(void) {
+    if (!is_selected("world_update_loaded_chunks", "budgeted_streaming")) {
+        return;
+    }
+
+    Bench_Result result = {
+        .benchmark = "world_update_loaded_chunks",
+        .pattern = "budgeted_streaming",
+        .ops_per_iteration = STREAM_STEPS,
+    };
+
+    size_t iterations = get_iterations(DEFAULT_STREAM_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        iVec3 center = {0, 0, 0};
+        reset_world(STREAM_LOAD_RADIUS, STREAM_VERTICAL_LOAD_RADIUS, generate_empty_chunk, center);
+        bench.world.memory_budget = bench.world.resident_bytes * 2;
+
+        uint64_t start_ns = get_time_ns();
+        for (int step = 0; step < STREAM_STEPS; step++) {
+            center.x++;
+            world_update_loaded_chunks(&bench.world, center);
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+}
+
+/* Times loading the whole world, with `worker_count` generation workers or none, and with or
+ * without placing features. */
+static void bench_world_generation(const char *pattern, size_t worker_count, bool is_populated) {
+    if (!is_selected("world_generation", pattern)) {
+        return;
+    }
+
+    if (bench.has_world) {
+        world_destroy(&bench.world);
+        bench.has_world = false;
+    }
+
+    Bench_Result result = {
+        .benchmark = "world_generation",
+        .pattern = pattern,
+    };
+
+    size_t iterations = get_iterations(DEFAULT_WORLD_GENERATION_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        World world;
+        if (!world_create(&world, WORLD_GENERATION_LOAD_RADIUS,
+                          WORLD_GENERATION_VERTICAL_LOAD_RADIUS, generate_chunk, NULL)) {
+            fprintf(stderr, "world_create() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (worker_count > 0 && !world_start_generation_workers(&world, worker_count)) {
+            fprintf(stderr, "world_start_generation_workers() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        world.max_loads_per_update = SIZE_MAX;
+        world.populate = is_populated ? populate_chunk : NULL;
+
+        /* The main thread only polls for finished chunks, so it shouldn't take time from the
+         * workers. */
+        uint64_t start_ns = get_time_ns();
+        world_update_loaded_chunks(&world, (iVec3){0, 0, 0});
+        while (world_is_loading(&world)) {
+            thread_yield();
+            world_update_loaded_chunks(&world, (iVec3){0, 0, 0});
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+
+        result.ops_per_iteration = world.chunks.count;
+        world_destroy(&world);
+    }
+
+    print_result(&result);
+}
+
+static Region_Storage *get_region_storage(void) {
+    if (!bench.has_region_storage) {
+        if (!region_storage_create(&bench.region_storage, BENCH_WORLD_DIRECTORY)) {
+            fprintf(stderr, "region_storage_create() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        bench.has_region_storage = true;
+    }
+
+    return &bench.region_storage;
+}
+
+/* Deletes everything the save benchmarks wrote. Only chunks of the pattern world are ever saved,
+ * so only the regions it covers can have files. */
+static void remove_bench_world(void) {
+    iVec3 radius = {PATTERN_LOAD_RADIUS, PATTERN_VERTICAL_LOAD_RADIUS, PATTERN_LOAD_RADIUS};
+    iVec3 min_region = ivec3_floor_div(ivec3_sub(BENCH_CHUNK_COORD, radius), REGION_SIZE);
+    iVec3 max_region = ivec3_floor_div(ivec3_add(BENCH_CHUNK_COORD, radius), REGION_SIZE);
+
+    bool removed = edit_journal_remove(BENCH_WORLD_DIRECTORY);
+    for (int z = min_region.z; z <= max_region.z; z++) {
+        for (int y = min_region.y; y <= max_region.y; y++) {
+            for (int x = min_region.x; x <= max_region.x; x++) {
+                removed = region_storage_remove_region(&bench.region_storage, (iVec3){x, y, z}) &&
+                          removed;
+            }
+        }
+    }
+
+    /* remove() deletes empty directories on POSIX systems. Elsewhere the empty directory is left
+     * behind. */
+    if (!removed) {
+        fprintf(stderr, "Failed to remove the files in %s\n", BENCH_WORLD_DIRECTORY);
+    } else {
+        remove(BENCH_WORLD_DIRECTORY);
+    }
+}
+
+/* Saves every chunk of the pattern world to its region file. */
+static void bench_region_save(Pattern pattern) {
+    if (!is_selected("region_save", PATTERN_NAMES[pattern])) {
+        return;
+    }
+
+    fill_pattern(pattern);
+    Region_Storage *storage = get_region_storage();
+
+    Bench_Result result = {
+        .benchmark = "region_save",
+        .pattern = PATTERN_NAMES[pattern],
+        .ops_per_iteration = bench.world.chunks.count,
+        .voxels_per_op = CHUNK_VOLUME,
+        .has_io_stats = true,
+        .uncompressed_bytes_per_op = CHUNK_VOLUME,
+    };
+
+    size_t iterations = get_iterations(DEFAULT_REGION_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t saved_bytes = storage->saved_bytes;
+
+        uint64_t start_ns = get_time_ns();
+        for (size_t j = 0; j < bench.world.chunks.capacity; j++) {
+            Chunk *chunk = bench.world.chunks.entries[j].chunk;
+            if (chunk && !region_storage_save_chunk(storage, chunk)) {
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (!region_storage_flush(storage)) {
+            fprintf(stderr, "region_storage_flush() failed\n");
+            exit(EXIT_FAILURE);
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+
+        result.stored_bytes_per_op =
+            (size_t)(storage->saved_bytes - saved_bytes) / bench.world.chunks.count;
+    }
+
+    print_result(&result);
+}
+
+/* Loads back every chunk saved by bench_region_save(). */
+static void bench_region_load(Pattern pattern) {
+    if (!is_selected("region_load", PATTERN_NAMES[pattern])) {
+        return;
+    }
+
+    fill_pattern(pattern);
+    Region_Storage *storage = get_region_storage();
+
+    for (size_t i = 0; i < bench.world.chunks.capacity; i++) {
+        Chunk *chunk = bench.world.chunks.entries[i].chunk;
+        if (chunk && !region_storage_save_chunk(storage, chunk)) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    Bench_Result result = {
+        .benchmark = "region_load",
+        .pattern = PATTERN_NAMES[pattern],
+        .ops_per_iteration = bench.world.chunks.count,
+        .voxels_per_op = CHUNK_VOLUME,
+        .has_io_stats = true,
+        .uncompressed_bytes_per_op = CHUNK_VOLUME,
+    };
+
+    Chunk chunk;
+    size_t iterations = get_iterations(DEFAULT_REGION_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t loaded_bytes = storage->loaded_bytes;
+
+        uint64_t start_ns = get_time_ns();
+        for (size_t j = 0; j < bench.world.chunks.capacity; j++) {
+            const Chunk *saved = bench.world.chunks.entries[j].chunk;
+            if (!saved) {
+                continue;
+            }
+
+            chunk_init(&chunk, saved->coord);
+            if (!region_storage_load_chunk(storage, &chunk)) {
+                fprintf(stderr, "region_storage_load_chunk() failed\n");
+                exit(EXIT_FAILURE);
+            }
+            chunk_destroy(&chunk);
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+
+        result.stored_bytes_per_op =
+            (size_t)(storage->loaded_bytes - loaded_bytes) / bench.world.chunks.count;
+    }
+
+    print_result(&result);
+}
+
+/* Toggles random blocks of the benchmarked chunk through world_set_block() with the edit journal
+ * attached. Edits per second is the inverse of the time per op. */
+static void bench_journal(const char *pattern, size_t edits_per_iteration, bool is_grouped) {
+    if (!is_selected("edit_journal", pattern)) {
+        return;
+    }
+
+    fill_pattern(PATTERN_FLAT);
+
+    Edit_Journal journal;
+    if (!edit_journal_open(&journal, get_region_storage()->directory)) {
+        fprintf(stderr, "edit_journal_open() failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bench.world.storage = get_region_storage();
+    bench.world.journal = &journal;
+
+    Bench_Result result = {
+        .benchmark = "edit_journal",
+        .pattern = pattern,
+        .ops_per_iteration = edits_per_iteration,
+        .has_io_stats = true,
+        .uncompressed_bytes_per_op = JOURNAL_BLOCK_RECORD_SIZE,
+        .stored_bytes_per_op = JOURNAL_BLOCK_RECORD_SIZE,
+    };
+
+    iVec3 chunk_origin = ivec3_scale(BENCH_CHUNK_COORD, CHUNK_SIZE);
+    uint32_t edit_index = 0;
+
+    size_t iterations = get_iterations(DEFAULT_JOURNAL_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start_ns = get_time_ns();
+        for (size_t j = 0; j < edits_per_iteration; j++) {
+            uint32_t hash = hash_u32(edit_index++);
+            iVec3 local = {
+                (int)(hash % CHUNK_SIZE),
+                (int)(hash / CHUNK_SIZE % CHUNK_SIZE),
+                (int)(hash / (CHUNK_SIZE * CHUNK_SIZE) % CHUNK_SIZE),
+            };
+            iVec3 position = ivec3_add(chunk_origin, local);
+
+            Block_Type old_block = world_get_block(&bench.world, position);
+            Block_Type new_block = old_block == BLOCK_AIR ? BLOCK_DIRT : BLOCK_AIR;
+            world_set_block(&bench.world, position, new_block);
+
+            if (!is_grouped) {
+                edit_journal_commit(&journal);
+            } else if ((j + 1) % JOURNAL_EDITS_PER_UPDATE == 0) {
+                world_update_loaded_chunks(&bench.world, BENCH_CHUNK_COORD);
+            }
+        }
+
+        edit_journal_commit(&journal);
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+
+    /* The edited chunks aren't worth saving. */
+    bench.world.storage = NULL;
+    bench.world.journal = NULL;
+    edit_journal_reset(&journal);
+    edit_journal_close(&journal);
+}
+
+/* Fills the same box alternately with dirt and air, either with world_fill_box() or one
+ * world_set_block() call per block. */
+static void bench_fill(bool is_batched) {
+    const char *benchmark = is_batched ? "world_fill_box" : "world_set_block";
+    if (!is_selected(benchmark, "box_64")) {
+        return;
+    }
+
+    reset_world(FILL_LOAD_RADIUS, FILL_VERTICAL_LOAD_RADIUS, generate_empty_chunk,
+                (iVec3){0, 0, 0});
+
+    Bench_Result result = {
+        .benchmark = benchmark,
+        .pattern = "box_64",
+        .ops_per_iteration = 1,
+        .voxels_per_op = FILL_BOX_SIZE * FILL_BOX_SIZE * FILL_BOX_SIZE,
+    };
+
+    iVec3 min = {-FILL_BOX_SIZE / 2 + 3, -FILL_BOX_SIZE / 2 + 5, -FILL_BOX_SIZE / 2 + 7};
+    iVec3 max = ivec3_add(min, (iVec3){FILL_BOX_SIZE, FILL_BOX_SIZE, FILL_BOX_SIZE});
+
+    size_t iterations = get_iterations(DEFAULT_FILL_ITERATIONS);
+    for (size_t i = 0; i < iterations; i++) {
+        Block_Type type = i % 2 == 0 ? BLOCK_DIRT : BLOCK_AIR;
+
+        uint64_t start_ns = get_time_ns();
+        if (is_batched) {
+            world_fill_box(&bench.world, min, max, type);
+        } else {
+            for (int z = min.z; z < max.z; z++) {
+                for (int y = min.y; y < max.y; y++) {
+                    for (int x = min.x; x < max.x; x++) {
+                        world_set_block(&bench.world, (iVec3){x, y, z}, type);
+                    }
+                }
+            }
+        }
+        record_iteration(&result, get_time_ns() - start_ns);
+    }
+
+    print_result(&result);
+}
+
+/* Walks the chunk map the way the game does with each layout: gathering the meshing data of every
+ * chunk, as after a meshing mode change, and building the draw ranges of every chunk in range. */
+static void bench_chunk_layout(Chunk_Map_Layout layout) {
+    const char *pattern = layout == CHUNK_MAP_LAYOUT_MORTON ? "morton" : "hashed";
+    bool is_gather_selected = is_selected("gather_all_chunks", pattern);
+    bool is_draw_list_selected = is_selected("draw_list", pattern);
+    if (!is_gather_selected && !is_draw_list_selected) {
+        return;
+    }
+
+    reset_world(LAYOUT_LOAD_RADIUS, LAYOUT_VERTICAL_LOAD_RADIUS, generate_empty_chunk,
+                (iVec3){0, 0, 0});
+    chunk_map_set_layout(&bench.world.chunks, layout);
+
+    const Chunk_Map *chunks = &bench.world.chunks;
+    size_t iterations = get_iterations(DEFAULT_LAYOUT_ITERATIONS);
+
+    if (is_gather_selected) {
+        Bench_Result result = {
+            .benchmark = "gather_all_chunks",
+            .pattern = pattern,
+            .ops_per_iteration = chunks->count,
+            .voxels_per_op = MESHING_DATA_VOLUME,
+        };
+
+        for (size_t i = 0; i < iterations; i++) {
+            uint64_t start_ns = get_time_ns();
+            for (size_t j = 0; j < chunks->capacity; j++) {
+                const Chunk *chunk = chunks->entries[j].chunk;
+                if (chunk) {
+                    world_get_meshing_data(&bench.world, chunk->coord, &bench.meshing_data);
+                }
+            }
+            record_iteration(&result, get_time_ns() - start_ns);
+        }
+
+        print_result(&result);
+    }
+
+    if (is_draw_list_selected) {
+        Bench_Result result = {
+            .benchmark = "draw_list",
+            .pattern = pattern,
+            .ops_per_iteration = chunks->count,
+        };
+
+        /* The chunks are empty, so they get made up meshes, laid out one after another in the
+         * quad buffer. A quarter of them have no mesh, like chunks of air. */
+        size_t mesh_start = 0;
+        for (size_t j = 0; j < chunks->capacity; j++) {
+            Chunk *chunk = chunks->entries[j].chunk;
+            if (!chunk) {
+                continue;
+            }
+
+            uint32_t hash = hash_u32((uint32_t)j);
+            bool has_mesh = hash % 4 != 0;
+
+            chunk->mesh = (Range){mesh_start, 0};
+            for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+                hash = hash_u32(hash);
+                chunk->mesh_direction_sizes[dir] = has_mesh ? hash % 512 : 0;
+                chunk->mesh.size += chunk->mesh_direction_sizes[dir];
+            }
+            mesh_start += chunk->mesh.size;
+        }
+
+        /* Builds the same draw ranges as the game's draw loop, for a camera in the center chunk. */
+        Vec3 camera_position = {CHUNK_SIZE * 0.5f, CHUNK_SIZE * 0.5f, CHUNK_SIZE * 0.5f};
+        volatile size_t range_sink = 0;
+        for (size_t i = 0; i < iterations; i++) {
+            uint64_t start_ns = get_time_ns();
+            size_t range_sum = 0;
+            for (size_t j = 0; j < chunks->capacity; j++) {
+                const Chunk *chunk = chunks->entries[j].chunk;
+                if (!chunk || chunk->mesh.size == 0 ||
+                    !world_is_chunk_in_range(&bench.world, chunk)) {
+                    continue;
+                }
+
+                Mesh_Draw_Ranges ranges;
+                get_mesh_draw_ranges(chunk, camera_position, &ranges);
+
+                /* Stands in for the draw call, so the ranges aren't optimized out. */
+                for (int k = 0; k < ranges.count; k++) {
+                    range_sum += ranges.firsts[k] + ranges.counts[k];
+                }
+            }
+            range_sink = range_sum;
+            record_iteration(&result, get_time_ns() - start_ns);
+        }
+        (void)range_sink;
+
+        print_result(&result);
+    }
+}
+
+static bool is_same_quad(const Quad *a, const Quad *b) {
+    return a->position.x == b->position.x && a->position.y == b->position.y &&
+           a->position.z == b->position.z && a->width == b->width && a->height == b->height &&
+           a->direction == b->direction && a->texture == b->texture && a->ao[0] == b->ao[0] &&
+           a->ao[1] == b->ao[1] && a->ao[2] == b->ao[2] && a->ao[3] == b->ao[3];
+}
+
+/* Round trips quads with every direction, corner ambient occlusion and texture id through
+ * encode_quad() and decode_quad(), then checks that the decoded quads of each pattern's mesh lie
+ * inside the chunk and are grouped under their own direction. */
+static bool run_quad_verification(void) {
+    size_t quad_count = 0;
+    size_t mismatch_count = 0;
+
+    for (Direction direction = 0; direction < DIRECTION_COUNT; direction++) {
+        for (uint32_t ao = 0; ao < 256; ao++) {
+            for (uint32_t texture = 0; texture < 512; texture++) {
+                uint32_t hash = hash_u32(hash_u32(hash_u32((uint32_t)direction) ^ ao) ^ texture);
+                Quad quad = {
+                    .position = {(int)(hash & 63), (int)((hash >> 6) & 63),
+                                 (int)((hash >> 12) & 63)},
+                    .width = (int)((hash >> 18) & 31) + 1,
+                    .height = (int)((hash >> 23) & 31) + 1,
+                    .direction = direction,
+                    .texture = (Texture_ID)texture,
+                    .ao = {(uint8_t)(ao & 3), (uint8_t)((ao >> 2) & 3), (uint8_t)((ao >> 4) & 3),
+                           (uint8_t)(ao >> 6)},
+                };
+
+                Quad decoded = decode_quad(encode_quad(&quad));
+                mismatch_count += !is_same_quad(&quad, &decoded);
+                quad_count++;
+            }
+        }
+    }
+
+    for (Pattern pattern = 0; pattern < PATTERN_COUNT; pattern++) {
+        fill_pattern(pattern);
+
+        Chunk_Mesh mesh;
+        mesh_chunk_greedy(&bench.meshing_data, &mesh, &bench.arena);
+
+        uint32_t index = 0;
+        for (Direction direction = 0; direction < DIRECTION_COUNT; direction++) {
+            for (uint32_t i = 0; i < mesh.direction_quad_counts[direction]; i++, index++) {
+                Quad quad = decode_quad(mesh.quads[index]);
+
+                iVec3 corners[4];
+                get_quad_corners(&quad, corners);
+
+                bool is_valid = quad.direction == direction && quad.texture < TEXTURE_ID_COUNT;
+                for (int j = 0; j < 4; j++) {
+                    is_valid = is_valid && corners[j].x >= 0 && corners[j].x <= CHUNK_SIZE &&
+                               corners[j].y >= 0 && corners[j].y <= CHUNK_SIZE &&
+                               corners[j].z >= 0 && corners[j].z <= CHUNK_SIZE;
+                }
+
+                mismatch_count += !is_valid;
+                quad_count++;
+            }
+        }
+
+        arena_reset(&bench.arena);
+    }
+
+    fprintf(stderr, "Quads: %zu quads checked, %zu mismatching quads\n", quad_count,
+            mismatch_count);
+
+    return mismatch_count == 0;
+}
+
+/* Checks every noise kernel the CPU supports against the scalar one. */
+static bool run_noise_verification(void) {
+    size_t sample_count = 0;
+    size_t mismatch_count = 0;
+
+    for (int dimensions = 2; dimensions <= 3; dimensions++) {
+        Noise_Samples expected = create_noise_samples(dimensions);
+        Noise_Samples actual = create_noise_samples(dimensions);
+        evaluate_noise(&BENCH_NOISE_SETTINGS, NOISE_KERNEL_SCALAR, dimensions, &expected);
+
+        for (Noise_Kernel kernel = NOISE_KERNEL_SCALAR + 1; kernel < NOISE_KERNEL_COUNT; kernel++) {
+            if (!noise_is_kernel_supported(kernel)) {
+                fprintf(stderr, "Noise: %s isn't supported by this CPU\n",
+                        noise_kernel_name(kernel));
+                continue;
+            }
+
+            /* The kernels must agree bit for bit, not just closely. */
+            evaluate_noise(&BENCH_NOISE_SETTINGS, kernel, dimensions, &actual);
+            for (size_t i = 0; i < expected.count; i++) {
+                mismatch_count += memcmp(&expected.out[i], &actual.out[i], sizeof(float)) != 0;
+            }
+            sample_count += expected.count;
+        }
+
+        destroy_noise_samples(&expected);
+        destroy_noise_samples(&actual);
+    }
+
+    fprintf(stderr, "Noise: %zu samples checked, %zu mismatching samples\n", sample_count,
+            mismatch_count);
+
+    return mismatch_count == 0;
+}
+
+/* Checks generate_chunk() against the per voxel path, and against generate_block(), on columns of
+ * chunks through the surface and the caves below it. */
+static bool run_terrain_verification(void) {
+    Chunk *expected = malloc(sizeof(Chunk));
+    Chunk *actual = malloc(sizeof(Chunk));
+    if (!expected || !actual) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t chunk_count = 0;
+    size_t mismatch_count = 0;
+    for (int i = 0; i < VERIFY_TERRAIN_COLUMNS * GENERATE_COLUMN_HEIGHT; i++) {
+        iVec3 chunk_coord = {i / GENERATE_COLUMN_HEIGHT - VERIFY_TERRAIN_COLUMNS / 2,
+                             i % GENERATE_COLUMN_HEIGHT, i / GENERATE_COLUMN_HEIGHT};
+        chunk_init(expected, chunk_coord);
+        chunk_init(actual, chunk_coord);
+        generate_chunk_per_voxel(expected, chunk_coord);
+        generate_chunk(actual, chunk_coord);
+
+        uint8_t expected_blocks[CHUNK_VOLUME];
+        uint8_t actual_blocks[CHUNK_VOLUME];
+        iVec3 max = {CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+        chunk_decode_unsafe(expected, (iVec3){0, 0, 0}, max, expected_blocks, CHUNK_SIZE,
+                            CHUNK_SIZE * CHUNK_SIZE);
+        chunk_decode_unsafe(actual, (iVec3){0, 0, 0}, max, actual_blocks, CHUNK_SIZE,
+                            CHUNK_SIZE * CHUNK_SIZE);
+
+        for (size_t j = 0; j < CHUNK_VOLUME; j++) {
+            mismatch_count += expected_blocks[j] != actual_blocks[j];
+        }
+
+        /* generate_block() samples its own cave cell, so a few blocks are checked against it. */
+        for (uint32_t j = 0; j < VERIFY_TERRAIN_BLOCKS; j++) {
+            uint32_t index = hash_u32(hash_u32((uint32_t)i) ^ j) % CHUNK_VOLUME;
+            iVec3 position = {(int)(index % CHUNK_SIZE), (int)((index / CHUNK_SIZE) % CHUNK_SIZE),
+                              (int)(index / (CHUNK_SIZE * CHUNK_SIZE))};
+            Block_Type block = generate_block(
+                ivec3_add(ivec3_scale(chunk_coord, CHUNK_SIZE), position));
+            mismatch_count += block != actual_blocks[index];
+        }
+        chunk_count++;
+
+        chunk_destroy(expected);
+        chunk_destroy(actual);
+    }
+
+    free(expected);
+    free(actual);
+
+    fprintf(stderr, "Terrain: %zu chunks checked, %zu mismatching blocks\n", chunk_count,
+            mismatch_count);
+
+    return mismatch_count == 0;
+}
+
+/* Checks the optimized meshing paths against their reference implementations on the patterns
+ * and on random chunks of varying density, the quad records against their decoder, the noise
+ * kernels against each other, and the terrain generator against its per voxel path. Returns true
+ * if they all agree. */
+static bool run_verification(void) {
+    size_t chunk_count = 0;
+    size_t mismatch_count = 0;
+
+    for (Pattern pattern = 0; pattern < PATTERN_COUNT; pattern++) {
+        fill_pattern(pattern);
+        mismatch_count += count_ao_mismatches(&bench.meshing_data);
+        chunk_count++;
+    }
+
+    for (uint32_t i = 0; i < VERIFY_RANDOM_CHUNKS; i++) {
+        /* From almost empty to almost solid. */
+        uint32_t solid_percent = 5 + (i * 90) / (VERIFY_RANDOM_CHUNKS - 1);
+
+        for (uint32_t j = 0; j < MESHING_DATA_VOLUME; j++) {
+            uint32_t hash = hash_u32(hash_u32(i) ^ j);
+            bool is_solid = hash % 100 < solid_percent;
+            bench.meshing_data.blocks[j] = is_solid ? (uint8_t)(1 + (hash >> 16) % 2) : BLOCK_AIR;
+        }
+
+        mismatch_count += count_ao_mismatches(&bench.meshing_data);
+        chunk_count++;
+    }
+
+    fprintf(stderr, "Ambient occlusion: %zu chunks checked, %zu mismatching faces\n", chunk_count,
+            mismatch_count);
+
+    bool is_quad_matching = run_quad_verification();
+    bool is_noise_matching = run_noise_verification();
+    bool is_terrain_matching = run_terrain_verification();
+    return mismatch_count == 0 && is_quad_matching && is_noise_matching && is_terrain_matching;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--iterations <count>] [--filter <benchmark/pattern substring>] [--verify]\n",
+            program);
+}
+
+static bool parse_args(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            char *end;
+            long count = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || count <= 0) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            bench.iterations_override = (size_t)count;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            bench.filter = argv[++i];
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            bench.verify = true;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    if (!arena_create(&bench.arena, MIB_TO_BYTES(16))) {
+        fprintf(stderr, "arena_create() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    meshing_init();
+    terrain_init(TERRAIN_DEFAULT_SEED, noise_get_fastest_kernel(), true);
+
+    if (bench.verify) {
+        bool passed = run_verification();
+
+        if (bench.has_world) {
+            world_destroy(&bench.world);
+        }
+
+        arena_destroy(&bench.arena);
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    print_csv_header();
+
+    for (Pattern pattern = 0; pattern < PATTERN_COUNT; pattern++) {
+        bench_gather(pattern);
+        bench_snapshot(pattern);
+        bench_mesh(MESHING_MODE_NAIVE, pattern);
+        bench_mesh(MESHING_MODE_GREEDY, pattern);
+        bench_region_save(pattern);
+        bench_region_load(pattern);
+    }
+
+    for (Noise_Kernel kernel = 0; kernel < NOISE_KERNEL_COUNT; kernel++) {
+        bench_noise(2, kernel);
+        bench_noise(3, kernel);
+    }
+
+    bench_generate("terrain", generate_chunk, true);
+    bench_generate("terrain_per_voxel", generate_chunk_per_voxel, true);
+    bench_generate("flat_terrain", generate_chunk, false);
+    bench_range_alloc();
+    bench_pop_dirty("loaded_world", POP_DIRTY_LOAD_RADIUS, POP_DIRTY_VERTICAL_LOAD_RADIUS, false);
+    bench_pop_dirty("streaming_world", POP_DIRTY_STREAMING_LOAD_RADIUS,
+                    POP_DIRTY_STREAMING_VERTICAL_LOAD_RADIUS, true);
+    bench_stream();
+
+    /* Leave one core for the main thread, as the game does. */
+    size_t processor_count = get_processor_count();
+    size_t generation_worker_count = processor_count > 1 ? processor_count - 1 : 1;
+    bench_world_generation("serial", 0, false);
+    bench_world_generation("parallel", generation_worker_count, false);
+    bench_world_generation("parallel_populated", generation_worker_count, true);
+
+    bench_fill(false);
+    bench_fill(true);
+    bench_journal("grouped", JOURNAL_GROUPED_EDITS, true);
+    bench_journal("unbatched", JOURNAL_UNBATCHED_EDITS, false);
+    bench_chunk_layout(CHUNK_MAP_LAYOUT_HASHED);
+    bench_chunk_layout(CHUNK_MAP_LAYOUT_MORTON);
+
+    if (bench.has_world) {
+        world_destroy(&bench.world);
+    }
+
+    if (bench.has_region_storage) {
+        remove_bench_world();
+        region_storage_destroy(&bench.region_storage);
+    }
+
+    arena_destroy(&bench.arena);
+    return EXIT_SUCCESS;
+}
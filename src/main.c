@@ -4,12 +4,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "render/mesh_workers.h"
 #include "render/meshing.h"
 #include "render/texture_array.h"
 #include "utils/range_allocator.h"
+#include "utils/thread.h"
+#include "utils/timer.h"
 #include "utils/utils.h"
 #include "world/camera.h"
 #include "world/chunk.h"
+#include "world/terrain.h"
 #include "world/world.h"
 
 #define GLFW_INCLUDE_NONE
@@ -21,6 +25,23 @@
 
 #define DEFAULT_CAMERA_SPEED 16.0f
 #define DEFAULT_MOUSE_SENSITIVITY 0.25f
+#define DEFAULT_MESH_BUDGET_MS 4.0f
+#define DEFAULT_LOAD_RADIUS 8
+#define DEFAULT_VERTICAL_LOAD_RADIUS 3
+#define MAX_LOAD_RADIUS 64
+#define DEFAULT_WORLD_DIRECTORY "world"
+#define DEFAULT_MEMORY_BUDGET_MIB 512
+
+/* Bounds on how many jobs are queued per mesh worker. */
+#define MIN_MESH_JOBS_PER_WORKER 1
+#define MAX_MESH_JOBS_PER_WORKER 64
+
+/* Weight of each new sample in the running per-chunk cost estimates. */
+#define COST_SMOOTHING 0.1
+
+/* Starting guesses for the cost estimates, replaced by measurements after the first few chunks. */
+#define INITIAL_MESH_COST_NS 200000.0
+#define INITIAL_UPLOAD_COST_NS_PER_BYTE 0.5
 
 static void glfw_error_callback(int error_code, const char *description) {
     (void)error_code;
@@ -102,12 +123,47 @@ struct {
 
     GLuint shader;
     GLuint vao;
-    GLuint vbo;
-    GLuint ebo;
+    GLuint ssbo;
     GLuint texture_array;
 
+    Meshing_Mode meshing_mode;
+    uint64_t gather_time_total_ns;
+    uint64_t mesh_time_total_ns;
+    size_t meshed_chunk_count;
+    size_t skipped_chunk_count;
+    size_t unfit_mesh_count;
+
+    size_t mesh_worker_count;
+    Mesh_Workers mesh_workers;
+
+    /* Main thread time per frame that may be spent meshing and uploading chunks. */
+    float mesh_budget_ms;
+    double mesh_cost_ns;
+    double upload_cost_ns_per_byte;
+
+    uint64_t throughput_window_start_ns;
+    size_t throughput_window_chunks;
+    size_t throughput_window_bytes;
+    size_t throughput_window_start_evictions;
+    double chunks_per_second;
+    double upload_bytes_per_second;
+    double evictions_per_second;
+
     Range_Allocator mesh_allocator;
+
+    int load_radius;
+    int vertical_load_radius;
+    size_t memory_budget_mib;
+    Chunk_Map_Layout chunk_layout;
+    size_t generation_worker_count;
+    uint32_t seed;
+    bool has_caves;
+    Noise_Kernel noise_kernel;
     World world;
+
+    const char *world_directory;
+    Region_Storage region_storage;
+    Edit_Journal journal;
 } state;
 
 static void window_size_callback(GLFWwindow *window, int width, int height) {
@@ -160,32 +216,12 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
 }
 
 #define MAX_QUADS ((CHUNK_VOLUME / 2) * 6)
-#define MAX_VERTS (MAX_QUADS * 4)
-#define VERTEX_BUFFER_SIZE (MAX_VERTS * 1000)
+#define QUAD_BUFFER_SIZE (MAX_QUADS * 1000)
 
-static Block_Type generate_block(iVec3 position) {
-    if (position.y < 100) {
-        return BLOCK_DIRT;
-    } else if (position.y == 100) {
-        return BLOCK_GRASS;
-    } else {
-        return BLOCK_AIR;
-    }
-}
-
-static void generate_chunk(Chunk *chunk, iVec3 chunk_coord) {
-    iVec3 world_offset = ivec3_scale(chunk_coord, CHUNK_SIZE);
-
-    for (int z = 0; z < CHUNK_SIZE; z++) {
-        for (int y = 0; y < CHUNK_SIZE; y++) {
-            for (int x = 0; x < CHUNK_SIZE; x++) {
-                iVec3 local_position = {x, y, z};
-                iVec3 world_position = ivec3_add(world_offset, local_position);
-
-                Block_Type type = generate_block(world_position);
-                chunk_set_block_unsafe(chunk, local_position, type);
-            }
-        }
+static void clear_chunk_mesh(Chunk *chunk) {
+    if (chunk->mesh.size != 0) {
+        range_free(&state.mesh_allocator, chunk->mesh);
+        chunk->mesh.size = 0;
     }
 }
 
@@ -260,6 +296,10 @@ static bool on_init(void) {
     state.cursor_locked = true;
 
     state.selected_block = BLOCK_DIRT;
+    state.meshing_mode = MESHING_MODE_GREEDY;
+    state.mesh_cost_ns = INITIAL_MESH_COST_NS;
+    state.upload_cost_ns_per_byte = INITIAL_UPLOAD_COST_NS_PER_BYTE;
+    state.throughput_window_start_ns = get_time_ns();
 
     camera_update(&state.camera);
 
@@ -277,40 +317,80 @@ static bool on_init(void) {
     cImGui_ImplGlfw_InitForOpenGL(state.window, true);
     cImGui_ImplOpenGL3_InitEx("#version 430");
 
-    for (int z = 0; z < WORLD_SIZE_Z; z++) {
-        for (int y = 0; y < WORLD_SIZE_Y; y++) {
-            for (int x = 0; x < WORLD_SIZE_X; x++) {
-                iVec3 chunk_coord = {x, y, z};
-                Chunk *chunk = world_get_chunk(&state.world, chunk_coord);
-                chunk->coord = chunk_coord;
-                generate_chunk(chunk, chunk_coord);
-                world_push_dirty_chunk(&state.world, chunk);
-            }
-        }
+    /* The vertex shader pulls quads straight from the storage buffer, so the vertex array has no
+     * attributes. It only exists because core profile draws require one to be bound. */
+    glGenVertexArrays(1, &state.vao);
+    glGenBuffers(1, &state.ssbo);
+
+    /* The whole buffer is bound as one storage block, so it can't be larger than the driver allows
+     * for a single block. GL 4.3 only guarantees 16 MiB. */
+    GLint64 max_block_size = 0;
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+
+    size_t quad_buffer_size = QUAD_BUFFER_SIZE;
+    if ((uint64_t)max_block_size / sizeof(uint64_t) < quad_buffer_size) {
+        quad_buffer_size = (size_t)((uint64_t)max_block_size / sizeof(uint64_t));
     }
 
-    uint32_t index_count = 0;
-    uint32_t *indices = generate_index_buffer(&index_count, &init_arena);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, state.ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(sizeof(uint64_t) * quad_buffer_size), NULL,
+                 GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, state.ssbo);
 
-    glGenVertexArrays(1, &state.vao);
-    glGenBuffers(1, &state.vbo);
-    glGenBuffers(1, &state.ebo);
+    state.texture_array = load_texture_array();
+    range_allocator_create(&state.mesh_allocator, quad_buffer_size);
 
-    glBindVertexArray(state.vao);
+    state.noise_kernel = noise_get_fastest_kernel();
+    terrain_init(state.seed, state.noise_kernel, state.has_caves);
 
-    glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizei)(sizeof(uint32_t) * VERTEX_BUFFER_SIZE), NULL,
-                 GL_DYNAMIC_DRAW);
+    /* Chunks are loaded around the camera from the first update on. */
+    if (!world_create(&state.world, state.load_radius, state.vertical_load_radius, generate_chunk,
+                      clear_chunk_mesh)) {
+        fprintf(stderr, "world_create() failed\n");
+        return false;
+    }
+
+    state.world.populate = populate_chunk;
+    state.world.memory_budget = (size_t)MIB_TO_BYTES(state.memory_budget_mib);
+    /* A quarter of the quad buffer is kept free for new meshes and fragmentation. */
+    state.world.mesh_budget = quad_buffer_size * sizeof(uint64_t) / 4 * 3;
+    chunk_map_set_layout(&state.world.chunks, state.chunk_layout);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizei)(sizeof(uint32_t) * index_count), indices,
-                 GL_STATIC_DRAW);
+    if (!region_storage_create(&state.region_storage, state.world_directory)) {
+        fprintf(stderr, "region_storage_create() failed\n");
+        return false;
+    }
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(uint32_t), NULL);
+    state.world.storage = &state.region_storage;
 
-    state.texture_array = load_texture_array();
-    range_allocator_create(&state.mesh_allocator, VERTEX_BUFFER_SIZE);
+    /* Edits that were journaled but never saved, because the game didn't exit cleanly, are
+     * applied before the first chunks load. */
+    if (!edit_journal_open(&state.journal, state.world_directory)) {
+        fprintf(stderr, "edit_journal_open() failed\n");
+        return false;
+    }
+
+    state.world.journal = &state.journal;
+
+    if (!world_replay_journal(&state.world)) {
+        fprintf(stderr, "world_replay_journal() failed\n");
+        return false;
+    }
+
+    /* Started after the replay, which loads the edited chunks while the world is still
+     * generated on this thread. */
+    if (state.generation_worker_count > 0 &&
+        !world_start_generation_workers(&state.world, state.generation_worker_count)) {
+        fprintf(stderr, "world_start_generation_workers() failed\n");
+        return false;
+    }
+
+    meshing_init();
+
+    if (!mesh_workers_create(&state.mesh_workers, state.mesh_worker_count)) {
+        fprintf(stderr, "mesh_workers_create() failed\n");
+        return false;
+    }
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
@@ -321,32 +401,186 @@ static bool on_init(void) {
 }
 
 static void on_quit(void) {
-    glDeleteBuffers(1, &state.ebo);
-    glDeleteBuffers(1, &state.vbo);
+    mesh_workers_destroy(&state.mesh_workers);
+    world_destroy(&state.world);
+    edit_journal_close(&state.journal);
+    region_storage_destroy(&state.region_storage);
+
+    glDeleteBuffers(1, &state.ssbo);
     glDeleteVertexArrays(1, &state.vao);
 
     glfwDestroyWindow(state.window);
     glfwTerminate();
 }
 
-static void get_meshing_data(const Chunk *chunk, Meshing_Data *data) {
-    iVec3 base_pos = ivec3_sub(ivec3_scale(chunk->coord, CHUNK_SIZE), (iVec3){1, 1, 1});
+static double update_cost_estimate(double estimate, double sample) {
+    return estimate + (sample - estimate) * COST_SMOOTHING;
+}
 
-    for (int z = 0; z < MESHING_DATA_SIZE; ++z) {
-        for (int y = 0; y < MESHING_DATA_SIZE; ++y) {
-            for (int x = 0; x < MESHING_DATA_SIZE; ++x) {
-                int mesh_index = (x) + MESHING_DATA_SIZE * ((y) + MESHING_DATA_SIZE * (z));
+static uint64_t get_elapsed_ns(uint64_t start_ns) {
+    return get_time_ns() - start_ns;
+}
 
-                data->blocks[mesh_index] =
-                    world_get_block(&state.world, ivec3_add(base_pos, (iVec3){x, y, z}));
-            }
+/* Returns the number of bytes uploaded. */
+static size_t upload_mesh_result(const Mesh_Result *result) {
+    Chunk *chunk = world_get_chunk(&state.world, result->chunk_coord);
+
+    /* The chunk was unloaded, or modified after the job was submitted and a newer mesh is on its
+     * way. */
+    if (!chunk || chunk->version != result->version) {
+        return 0;
+    }
+
+    clear_chunk_mesh(chunk);
+
+    size_t uploaded_bytes = 0;
+    const Chunk_Mesh *mesh = &result->mesh;
+    /* Out of range meshes are evicted before the buffer fills up, but the meshes in range alone
+     * can still fill it. The chunk is then left without a mesh until it is remeshed. */
+    if (mesh->quad_count > 0 &&
+        !range_alloc(&state.mesh_allocator, mesh->quad_count, &chunk->mesh)) {
+        state.unfit_mesh_count++;
+    } else if (mesh->quad_count > 0) {
+        GLintptr buffer_offset = (GLintptr)(chunk->mesh.start * sizeof(uint64_t));
+        GLsizeiptr buffer_size = (GLsizeiptr)(chunk->mesh.size * sizeof(uint64_t));
+
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, buffer_offset, buffer_size, mesh->quads);
+
+        memcpy(chunk->mesh_direction_sizes, mesh->direction_quad_counts,
+               sizeof(chunk->mesh_direction_sizes));
+
+        uploaded_bytes = (size_t)buffer_size;
+    }
+
+    world_update_chunk_memory(&state.world, chunk);
+
+    uint64_t job_time_ns = result->gather_time_ns + result->mesh_time_ns;
+    state.mesh_cost_ns = update_cost_estimate(state.mesh_cost_ns, (double)job_time_ns);
+
+    state.gather_time_total_ns += result->gather_time_ns;
+    state.mesh_time_total_ns += result->mesh_time_ns;
+    state.meshed_chunk_count++;
+    state.throughput_window_chunks++;
+    state.throughput_window_bytes += uploaded_bytes;
+
+    return uploaded_bytes;
+}
+
+/* Pops the next finished mesh and uploads it, updating the upload cost estimate. */
+static void upload_next_mesh_result(void) {
+    Mesh_Result *result = mesh_workers_pop_result(&state.mesh_workers);
+    if (!result) {
+        return;
+    }
+
+    uint64_t upload_start_ns = get_time_ns();
+    size_t uploaded_bytes = upload_mesh_result(result);
+    uint64_t upload_time_ns = get_elapsed_ns(upload_start_ns);
+
+    if (uploaded_bytes > 0) {
+        state.upload_cost_ns_per_byte = update_cost_estimate(
+            state.upload_cost_ns_per_byte, (double)upload_time_ns / (double)uploaded_bytes);
+    }
+
+    mesh_workers_free_result(result);
+}
+
+/* Uploads finished meshes until the frame's budget would be exceeded. At least one mesh is
+ * uploaded per call so a single large mesh can't stall the queue. */
+static void upload_mesh_results(uint64_t frame_start_ns, uint64_t budget_ns) {
+    bool uploaded_any = false;
+
+    const Mesh_Result *next;
+    while ((next = mesh_workers_peek_result(&state.mesh_workers))) {
+        double predicted_ns =
+            (double)(next->mesh.quad_count * sizeof(uint64_t)) * state.upload_cost_ns_per_byte;
+
+        if (uploaded_any &&
+            (double)get_elapsed_ns(frame_start_ns) + predicted_ns > (double)budget_ns) {
+            break;
         }
+
+        upload_next_mesh_result();
+        uploaded_any = true;
     }
 }
 
-static void on_update(float delta_time) {
-    (void)delta_time;
+/* Pops dirty chunks and hands them to the mesh workers until the frame's budget is used. */
+static void dispatch_dirty_chunks(uint64_t frame_start_ns, uint64_t budget_ns,
+                                  iVec3 player_position, float delta_time) {
+    /* Queue roughly one frame of work per worker so none of them idle, but not much more, so the
+     * queue keeps following the closest chunks as the player moves. Without workers the chunks
+     * are meshed on this thread, so their cost comes out of the budget instead. */
+    size_t max_in_flight = MIN_MESH_JOBS_PER_WORKER;
+    double main_thread_cost_ns = state.mesh_cost_ns;
+
+    if (state.mesh_worker_count > 0) {
+        double jobs_per_frame = (double)delta_time * NS_PER_SECOND / state.mesh_cost_ns;
+        size_t jobs_per_worker = MIN_MESH_JOBS_PER_WORKER;
+        if (jobs_per_frame > MAX_MESH_JOBS_PER_WORKER) {
+            jobs_per_worker = MAX_MESH_JOBS_PER_WORKER;
+        } else if (jobs_per_frame > MIN_MESH_JOBS_PER_WORKER) {
+            jobs_per_worker = (size_t)jobs_per_frame;
+        }
+
+        max_in_flight = jobs_per_worker * state.mesh_worker_count;
+        main_thread_cost_ns = 0.0;
+    }
+
+    bool dispatched_any = false;
+    while (state.mesh_workers.in_flight < max_in_flight) {
+        double elapsed_ns = (double)get_elapsed_ns(frame_start_ns);
+        if (dispatched_any && elapsed_ns + main_thread_cost_ns > (double)budget_ns) {
+            break;
+        }
+
+        Chunk *next_dirty = world_pop_dirty_chunk(&state.world, player_position);
+        if (!next_dirty) {
+            break;
+        }
 
+        dispatched_any = true;
+
+        /* Empty and buried chunks don't need to go through the gather and mesher at all. */
+        if (world_is_chunk_mesh_empty(&state.world, next_dirty)) {
+            clear_chunk_mesh(next_dirty);
+            world_update_chunk_memory(&state.world, next_dirty);
+            state.skipped_chunk_count++;
+            state.throughput_window_chunks++;
+            continue;
+        }
+
+        mesh_workers_submit(&state.mesh_workers, &state.world, next_dirty, state.meshing_mode);
+
+        /* Without workers the mesh is finished by now. Uploading it straight away keeps nothing
+         * in flight, so only the budget ends the loop. */
+        if (state.mesh_worker_count == 0) {
+            upload_next_mesh_result();
+        }
+    }
+}
+
+static void update_throughput(void) {
+    uint64_t now_ns = get_time_ns();
+    uint64_t window_ns = now_ns - state.throughput_window_start_ns;
+    if (window_ns < NS_PER_SECOND) {
+        return;
+    }
+
+    double window_seconds = (double)window_ns / NS_PER_SECOND;
+    state.chunks_per_second = (double)state.throughput_window_chunks / window_seconds;
+    state.upload_bytes_per_second = (double)state.throughput_window_bytes / window_seconds;
+    state.evictions_per_second =
+        (double)(state.world.evicted_chunk_count - state.throughput_window_start_evictions) /
+        window_seconds;
+
+    state.throughput_window_start_ns = now_ns;
+    state.throughput_window_start_evictions = state.world.evicted_chunk_count;
+    state.throughput_window_chunks = 0;
+    state.throughput_window_bytes = 0;
+}
+
+static void on_update(float delta_time) {
     Vec3 move_dir = {0};
     if (glfwGetKey(state.window, GLFW_KEY_W)) {
         move_dir = vec3_add(move_dir, state.camera.forward);
@@ -380,46 +614,49 @@ static void on_update(float delta_time) {
         world_set_block(&state.world, place_pos, state.selected_block);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, state.ssbo);
 
     iVec3 player_position = {
-        (int)state.camera.position.x,
-        (int)state.camera.position.y,
-        (int)state.camera.position.z,
+        (int)floorf(state.camera.position.x),
+        (int)floorf(state.camera.position.y),
+        (int)floorf(state.camera.position.z),
     };
 
     player_position = ivec3_floor_div(player_position, CHUNK_SIZE);
 
-    for (size_t i = 0; i < 3; i++) {
-        Chunk *next_dirty = world_pop_dirty_chunk(&state.world, player_position);
-        if (next_dirty) {
-            Meshing_Data data;
-            get_meshing_data(next_dirty, &data);
-
-            uint32_t vertex_count;
-            uint32_t *vertices = mesh_chunk(&data, &vertex_count, &state.frame_arena);
-            if (vertex_count >= 0) {
-                if (next_dirty->mesh.size != 0) {
-                    range_free(&state.mesh_allocator, next_dirty->mesh);
-                    next_dirty->mesh.size = 0;
-                }
-
-                if (vertex_count > 0) {
-                    next_dirty->mesh = range_alloc(&state.mesh_allocator, vertex_count);
-
-                    GLsizei buffer_offset = (GLsizei)(next_dirty->mesh.start * sizeof(uint32_t));
-                    GLsizei buffer_size = (GLsizei)(next_dirty->mesh.size * sizeof(uint32_t));
-
-                    glBufferSubData(GL_ARRAY_BUFFER, buffer_offset, buffer_size, vertices);
-                }
-            }
-        }
-    }
+    world_update_loaded_chunks(&state.world, player_position);
+
+    /* Finished meshes are uploaded first since they're the oldest work, then again after the
+     * dispatch to pick up any the workers finished in the meantime. */
+    uint64_t frame_start_ns = get_time_ns();
+    uint64_t budget_ns = (uint64_t)((double)state.mesh_budget_ms * 1e6);
+
+    upload_mesh_results(frame_start_ns, budget_ns);
+    dispatch_dirty_chunks(frame_start_ns, budget_ns, player_position, delta_time);
+    upload_mesh_results(frame_start_ns, budget_ns);
+
+    update_throughput();
 
     arena_reset(&state.frame_arena);
 }
 
-static void on_draw_imgui(int draw_calls, size_t tri_count) {
+static void set_meshing_mode(Meshing_Mode mode) {
+    state.meshing_mode = mode;
+    state.gather_time_total_ns = 0;
+    state.mesh_time_total_ns = 0;
+    state.meshed_chunk_count = 0;
+    state.skipped_chunk_count = 0;
+
+    /* Remesh everything so the statistics reflect the new mode. */
+    for (size_t i = 0; i < state.world.chunks.capacity; i++) {
+        Chunk *chunk = state.world.chunks.entries[i].chunk;
+        if (chunk) {
+            world_push_dirty_chunk(&state.world, chunk);
+        }
+    }
+}
+
+static void on_draw_imgui(int draw_calls, size_t tri_count, size_t culled_tri_count) {
     ImGuiIO *io = ImGui_GetIO();
 
     cImGui_ImplOpenGL3_NewFrame();
@@ -451,10 +688,74 @@ static void on_draw_imgui(int draw_calls, size_t tri_count) {
 
     ImGui_Text("Frame Time: %fms", (1.0 / io->Framerate) * 1000.0);
     ImGui_Text("Draw calls: %i", draw_calls);
-    ImGui_Text("Tri count: %zu", tri_count);
-    ImGui_Text("VRAM Usage: %zu KiB  / %zu KiB", state.mesh_allocator.used / 1024,
-               state.mesh_allocator.capacity / 1024);
-    ImGui_Text("Pending dirty chunks: %zu", state.world.dirty_list_count);
+    ImGui_Text("Tri count: %zu (%zu culled by face direction)", tri_count, culled_tri_count);
+    ImGui_Text("VRAM Usage: %zu KiB  / %zu KiB (%zu meshes didn't fit)",
+               state.mesh_allocator.used * sizeof(uint64_t) / 1024,
+               state.mesh_allocator.capacity * sizeof(uint64_t) / 1024, state.unfit_mesh_count);
+    ImGui_Text("Resident chunks: %zu (radius %d, vertical radius %d)", state.world.chunks.count,
+               state.load_radius, state.vertical_load_radius);
+    ImGui_Text("Terrain seed: %u%s, noise kernel: %s", state.seed,
+               state.has_caves ? "" : " (no caves)", noise_kernel_name(state.noise_kernel));
+    ImGui_Text("Resident memory: %zu KiB / %zu KiB, evictions: %.1f/s (%zu total)",
+               state.world.resident_bytes / 1024, state.world.memory_budget / 1024,
+               state.evictions_per_second, state.world.evicted_chunk_count);
+    ImGui_Text("Pending dirty chunks: %zu", state.world.dirty_queue_count);
+    ImGui_Text("Generation workers: %zu (%zu chunks being generated)",
+               state.generation_worker_count,
+               state.world.has_generation_workers ? state.world.generating_chunks.count : 0);
+    ImGui_Text("Saved chunks: %zu (%llu KiB), loaded chunks: %zu (%llu KiB)",
+               state.region_storage.saved_chunk_count,
+               (unsigned long long)(state.region_storage.saved_bytes / 1024),
+               state.region_storage.loaded_chunk_count,
+               (unsigned long long)(state.region_storage.loaded_bytes / 1024));
+
+    ImGui_Text("Journal: %llu edits in %llu commits, %zu pending, %llu KiB",
+               (unsigned long long)state.journal.committed_edit_count,
+               (unsigned long long)state.journal.commit_count, state.journal.pending_count,
+               (unsigned long long)(state.journal.file_size / 1024));
+
+    if (ImGui_Button("Save world")) {
+        world_save(&state.world);
+    }
+
+    ImGui_Text("Mesh arena peak: %zu KiB",
+               mesh_workers_get_peak_arena_usage(&state.mesh_workers) / 1024);
+
+    if (ImGui_BeginCombo("Meshing Mode", get_meshing_mode_name(state.meshing_mode), 0)) {
+        for (Meshing_Mode mode = 0; mode < MESHING_MODE_COUNT; mode++) {
+            bool is_selected = state.meshing_mode == mode;
+
+            if (ImGui_Selectable(get_meshing_mode_name(mode)) && !is_selected) {
+                set_meshing_mode(mode);
+            }
+
+            if (is_selected) {
+                ImGui_SetItemDefaultFocus();
+            }
+        }
+
+        ImGui_EndCombo();
+    }
+
+    double average_gather_time = 0.0;
+    double average_mesh_time = 0.0;
+    if (state.meshed_chunk_count > 0) {
+        average_gather_time = (double)state.gather_time_total_ns / (double)state.meshed_chunk_count;
+        average_mesh_time = (double)state.mesh_time_total_ns / (double)state.meshed_chunk_count;
+    }
+
+    ImGui_Text("Average gather time: %fms", average_gather_time / 1e6);
+    ImGui_Text("Average mesh time: %fms (%zu chunks)", average_mesh_time / 1e6,
+               state.meshed_chunk_count);
+    ImGui_Text("Skipped empty or buried chunks: %zu", state.skipped_chunk_count);
+    ImGui_Text("Mesh workers: %zu (%zu jobs in flight)", state.mesh_worker_count,
+               state.mesh_workers.in_flight);
+
+    ImGui_SliderFloat("Mesh budget (ms)", &state.mesh_budget_ms, 0.5f, 16.0f);
+    ImGui_Text("Estimated cost: %.3fms mesh per chunk, %.3fns upload per byte",
+               state.mesh_cost_ns / 1e6, state.upload_cost_ns_per_byte);
+    ImGui_Text("Throughput: %.0f chunks/s, %.2f MiB/s uploaded", state.chunks_per_second,
+               state.upload_bytes_per_second / (1024.0 * 1024.0));
 
     ImGui_End();
 
@@ -514,34 +815,164 @@ static void on_draw(float delta_time) {
 
     int draw_calls = 0;
     size_t tri_count = 0;
-    for (int z = 0; z < WORLD_SIZE_Z; z++) {
-        for (int y = 0; y < WORLD_SIZE_Y; y++) {
-            for (int x = 0; x < WORLD_SIZE_X; x++) {
-                Chunk *chunk = world_get_chunk(&state.world, (iVec3){x, y, z});
-                if (chunk->mesh.size == 0) {
-                    continue;
-                }
-
-                Vec3 position = vec3_scale((Vec3){x, y, z}, CHUNK_SIZE);
-                uniform_vec3(state.shader, "u_position", position);
-
-                size_t quad_count = chunk->mesh.size / 4;
-
-                GLsizei count = (chunk->mesh.size / 4) * 6;
-                GLsizei base_vertex = (GLsizei)chunk->mesh.start;
-                glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0, base_vertex);
-                draw_calls++;
-                tri_count += quad_count * 2;
-            }
+    size_t culled_tri_count = 0;
+
+    /* Slot order is Morton order within each tile of the map, see Chunk_Map_Layout. */
+    for (size_t i = 0; i < state.world.chunks.capacity; i++) {
+        Chunk *chunk = state.world.chunks.entries[i].chunk;
+
+        /* Chunks out of range are only kept around in case the player comes back. */
+        if (!chunk || chunk->mesh.size == 0 || !world_is_chunk_in_range(&state.world, chunk)) {
+            continue;
+        }
+
+        Mesh_Draw_Ranges ranges;
+        get_mesh_draw_ranges(chunk, state.camera.position, &ranges);
+
+        tri_count += ranges.drawn_quad_count * 2;
+        culled_tri_count += ranges.culled_quad_count * 2;
+
+        if (ranges.count == 0) {
+            continue;
+        }
+
+        /* Each quad is drawn as 6 vertices, see chunk.vert. */
+        GLint firsts[DIRECTION_COUNT];
+        GLsizei counts[DIRECTION_COUNT];
+        for (int j = 0; j < ranges.count; j++) {
+            firsts[j] = (GLint)(ranges.firsts[j] * 6);
+            counts[j] = (GLsizei)(ranges.counts[j] * 6);
         }
+
+        Vec3 position = vec3_scale((Vec3){chunk->coord.x, chunk->coord.y, chunk->coord.z},
+                                   CHUNK_SIZE);
+
+        uniform_vec3(state.shader, "u_position", position);
+
+        glMultiDrawArrays(GL_TRIANGLES, firsts, counts, ranges.count);
+        draw_calls++;
     }
 
-    on_draw_imgui(draw_calls, tri_count);
+    on_draw_imgui(draw_calls, tri_count, culled_tri_count);
 
     glfwSwapBuffers(state.window);
 }
 
-int main(void) {
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--mesh-workers <count>] [--mesh-budget-ms <milliseconds>]\n"
+            "          [--load-radius <chunks>] [--vertical-load-radius <chunks>]\n"
+            "          [--world-dir <directory>] [--memory-budget-mib <mebibytes>]\n"
+            "          [--chunk-layout <morton|hashed>] [--seed <number>]\n"
+            "          [--generation-workers <count>] [--no-caves]\n",
+            program);
+}
+
+static bool parse_args(int argc, char **argv) {
+    /* Leave one core for the main thread by default. */
+    size_t processor_count = get_processor_count();
+    state.mesh_worker_count = processor_count > 1 ? processor_count - 1 : 1;
+    state.generation_worker_count = state.mesh_worker_count;
+    state.mesh_budget_ms = DEFAULT_MESH_BUDGET_MS;
+    state.load_radius = DEFAULT_LOAD_RADIUS;
+    state.vertical_load_radius = DEFAULT_VERTICAL_LOAD_RADIUS;
+    state.world_directory = DEFAULT_WORLD_DIRECTORY;
+    state.memory_budget_mib = DEFAULT_MEMORY_BUDGET_MIB;
+    state.chunk_layout = CHUNK_MAP_LAYOUT_MORTON;
+    state.seed = TERRAIN_DEFAULT_SEED;
+    state.has_caves = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mesh-workers") == 0 && i + 1 < argc) {
+            char *end;
+            long count = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || count < 0) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            state.mesh_worker_count = (size_t)count;
+        } else if (strcmp(argv[i], "--generation-workers") == 0 && i + 1 < argc) {
+            char *end;
+            long count = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || count < 0) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            state.generation_worker_count = (size_t)count;
+        } else if (strcmp(argv[i], "--mesh-budget-ms") == 0 && i + 1 < argc) {
+            char *end;
+            float budget_ms = strtof(argv[++i], &end);
+            if (*end != '\0' || !(budget_ms > 0.0f)) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            state.mesh_budget_ms = budget_ms;
+        } else if ((strcmp(argv[i], "--load-radius") == 0 ||
+                    strcmp(argv[i], "--vertical-load-radius") == 0) &&
+                   i + 1 < argc) {
+            bool is_vertical = strcmp(argv[i], "--vertical-load-radius") == 0;
+
+            char *end;
+            long radius = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || radius < 0 || radius > MAX_LOAD_RADIUS) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            if (is_vertical) {
+                state.vertical_load_radius = (int)radius;
+            } else {
+                state.load_radius = (int)radius;
+            }
+        } else if (strcmp(argv[i], "--world-dir") == 0 && i + 1 < argc) {
+            state.world_directory = argv[++i];
+        } else if (strcmp(argv[i], "--memory-budget-mib") == 0 && i + 1 < argc) {
+            char *end;
+            long budget_mib = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || budget_mib < 0) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            state.memory_budget_mib = (size_t)budget_mib;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            char *end;
+            unsigned long seed = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || seed > UINT32_MAX) {
+                print_usage(argv[0]);
+                return false;
+            }
+
+            state.seed = (uint32_t)seed;
+        } else if (strcmp(argv[i], "--no-caves") == 0) {
+            state.has_caves = false;
+        } else if (strcmp(argv[i], "--chunk-layout") == 0 && i + 1 < argc) {
+            const char *layout = argv[++i];
+            if (strcmp(layout, "morton") == 0) {
+                state.chunk_layout = CHUNK_MAP_LAYOUT_MORTON;
+            } else if (strcmp(layout, "hashed") == 0) {
+                state.chunk_layout = CHUNK_MAP_LAYOUT_HASHED;
+            } else {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
     if (!on_init()) {
         fprintf(stderr, "Failed to initialize\n");
         return EXIT_FAILURE;
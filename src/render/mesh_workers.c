@@ -0,0 +1,213 @@
+#include "mesh_workers.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/timer.h"
+
+typedef struct Mesh_Job {
+    Mesh_Workers *workers;
+    iVec3 chunk_coord;
+    uint32_t version;
+    Meshing_Mode mode;
+
+    Chunk_Neighborhood neighborhood;
+    Meshing_Data data;
+} Mesh_Job;
+
+static void push_result(Mesh_Workers *workers, Mesh_Result *result) {
+    mutex_lock(&workers->result_mutex);
+
+    if (workers->result_tail) {
+        workers->result_tail->next = result;
+    } else {
+        workers->result_head = result;
+    }
+    workers->result_tail = result;
+
+    mutex_unlock(&workers->result_mutex);
+}
+
+static void mesh_job(void *user_data, size_t worker_index) {
+    Mesh_Job *job = user_data;
+    Mesh_Workers *workers = job->workers;
+
+    assert(worker_index < workers->arena_count);
+    Arena *arena = &workers->arenas[worker_index];
+
+    Mesh_Result *result = malloc(sizeof(Mesh_Result));
+    if (!result) {
+        fprintf(stderr, "Mesh workers are out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *result = (Mesh_Result){
+        .chunk_coord = job->chunk_coord,
+        .version = job->version,
+    };
+
+    /* The snapshots don't change however the chunks are edited meanwhile, so they are read
+     * without locks, and released as soon as the blocks are gathered. */
+    uint64_t gather_start = get_time_ns();
+    world_get_neighborhood_meshing_data(&job->neighborhood, &job->data);
+    world_release_neighborhood(&job->neighborhood);
+
+    uint64_t mesh_start = get_time_ns();
+
+    Chunk_Mesh mesh;
+    mesh_chunk_with_mode(&job->data, job->mode, &mesh, arena);
+
+    result->gather_time_ns = mesh_start - gather_start;
+    result->mesh_time_ns = get_time_ns() - mesh_start;
+
+    /* Copy the vertices out of the arena, at their exact size. */
+    result->mesh = mesh;
+    if (mesh.quad_count > 0) {
+        result->mesh.quads = malloc(sizeof(uint64_t) * mesh.quad_count);
+        if (!result->mesh.quads) {
+            fprintf(stderr, "Mesh workers are out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+
+        memcpy(result->mesh.quads, mesh.quads, sizeof(uint64_t) * mesh.quad_count);
+    }
+
+    arena_reset(arena);
+    free(job);
+
+    push_result(workers, result);
+}
+
+bool mesh_workers_create(Mesh_Workers *workers, size_t worker_count) {
+    assert(workers != NULL);
+
+    *workers = (Mesh_Workers){0};
+
+    /* The inline mode still needs one arena for the calling thread. */
+    workers->arena_count = worker_count > 0 ? worker_count : 1;
+    workers->arenas = calloc(workers->arena_count, sizeof(Arena));
+    if (!workers->arenas) {
+        return false;
+    }
+
+    for (size_t i = 0; i < workers->arena_count; i++) {
+        if (!arena_create(&workers->arenas[i], MIB_TO_BYTES(16))) {
+            return false;
+        }
+    }
+
+    mutex_create(&workers->result_mutex);
+
+    if (!thread_pool_create(&workers->pool, worker_count)) {
+        return false;
+    }
+
+    return true;
+}
+
+void mesh_workers_destroy(Mesh_Workers *workers) {
+    assert(workers != NULL);
+
+    /* Waits for outstanding jobs, so nothing touches the results after this. */
+    thread_pool_destroy(&workers->pool);
+
+    Mesh_Result *result;
+    while ((result = mesh_workers_pop_result(workers))) {
+        mesh_workers_free_result(result);
+    }
+
+    mutex_destroy(&workers->result_mutex);
+
+    for (size_t i = 0; i < workers->arena_count; i++) {
+        arena_destroy(&workers->arenas[i]);
+    }
+
+    free(workers->arenas);
+    *workers = (Mesh_Workers){0};
+}
+
+void mesh_workers_submit(Mesh_Workers *workers, const World *world, const Chunk *chunk,
+                         Meshing_Mode mode) {
+    assert(workers != NULL);
+    assert(world != NULL);
+    assert(chunk != NULL);
+
+    Mesh_Job *job = malloc(sizeof(Mesh_Job));
+    if (!job) {
+        fprintf(stderr, "Mesh workers are out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *job = (Mesh_Job){
+        .workers = workers,
+        .chunk_coord = chunk->coord,
+        .version = chunk->version,
+        .mode = mode,
+    };
+
+    /* Chunks are loaded, unloaded and edited on this thread, so the workers get snapshots of the
+     * neighborhood rather than reading the world while it changes under them. */
+    world_snapshot_neighborhood(world, chunk->coord, &job->neighborhood);
+
+    workers->in_flight++;
+    thread_pool_submit(&workers->pool, mesh_job, job);
+}
+
+Mesh_Result *mesh_workers_pop_result(Mesh_Workers *workers) {
+    assert(workers != NULL);
+
+    mutex_lock(&workers->result_mutex);
+
+    Mesh_Result *result = workers->result_head;
+    if (result) {
+        workers->result_head = result->next;
+        if (!workers->result_head) {
+            workers->result_tail = NULL;
+        }
+
+        result->next = NULL;
+    }
+
+    mutex_unlock(&workers->result_mutex);
+
+    if (result && workers->in_flight > 0) {
+        workers->in_flight--;
+    }
+
+    return result;
+}
+
+const Mesh_Result *mesh_workers_peek_result(Mesh_Workers *workers) {
+    assert(workers != NULL);
+
+    /* Workers only ever append, so the head stays valid until it is popped. */
+    mutex_lock(&workers->result_mutex);
+    const Mesh_Result *result = workers->result_head;
+    mutex_unlock(&workers->result_mutex);
+
+    return result;
+}
+
+void mesh_workers_free_result(Mesh_Result *result) {
+    if (!result) {
+        return;
+    }
+
+    free(result->mesh.quads);
+    free(result);
+}
+
+size_t mesh_workers_get_peak_arena_usage(const Mesh_Workers *workers) {
+    assert(workers != NULL);
+
+    size_t peak = 0;
+    for (size_t i = 0; i < workers->arena_count; i++) {
+        if (workers->arenas[i].peak_offset > peak) {
+            peak = workers->arenas[i].peak_offset;
+        }
+    }
+
+    return peak;
+}
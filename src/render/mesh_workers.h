@@ -0,0 +1,63 @@
+#ifndef MESH_WORKERS_H
+#define MESH_WORKERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "render/meshing.h"
+#include "utils/arena.h"
+#include "utils/thread_pool.h"
+#include "world/world.h"
+
+typedef struct Mesh_Result {
+    iVec3 chunk_coord;
+
+    /* The chunk version the mesh was built from. If the chunk's version has moved on since, the
+     * mesh is stale and should be discarded. */
+    uint32_t version;
+
+    /* The quads are owned by the result. */
+    Chunk_Mesh mesh;
+
+    uint64_t gather_time_ns;
+    uint64_t mesh_time_ns;
+
+    struct Mesh_Result *next;
+} Mesh_Result;
+
+typedef struct Mesh_Workers {
+    Thread_Pool pool;
+
+    /* One scratch arena per worker. */
+    Arena *arenas;
+    size_t arena_count;
+
+    Mutex result_mutex;
+    Mesh_Result *result_head;
+    Mesh_Result *result_tail;
+
+    /* Jobs submitted whose results have not been popped yet. Only touched by the submitting
+     * thread. */
+    size_t in_flight;
+} Mesh_Workers;
+
+/* With a worker count of zero, chunks are meshed synchronously inside mesh_workers_submit(). */
+bool mesh_workers_create(Mesh_Workers *workers, size_t worker_count);
+void mesh_workers_destroy(Mesh_Workers *workers);
+
+/* Snapshots the chunks the mesh depends on, then gathers their blocks and meshes them on a
+ * worker thread. */
+void mesh_workers_submit(Mesh_Workers *workers, const World *world, const Chunk *chunk,
+                         Meshing_Mode mode);
+
+/* Returns the next finished mesh, or NULL if there is none. The result must be released with
+ * mesh_workers_free_result(). */
+Mesh_Result *mesh_workers_pop_result(Mesh_Workers *workers);
+
+/* Returns the result mesh_workers_pop_result() would return next without removing it, or NULL. */
+const Mesh_Result *mesh_workers_peek_result(Mesh_Workers *workers);
+void mesh_workers_free_result(Mesh_Result *result);
+
+size_t mesh_workers_get_peak_arena_usage(const Mesh_Workers *workers);
+
+#endif /* MESH_WORKERS_H */
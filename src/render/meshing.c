@@ -1,16 +1,11 @@
 #include "meshing.h"
 
 #include <assert.h>
+#include <string.h>
 
+#include "utils/bits.h"
 #include "utils/direction.h"
 
-/* The maximum number of quads a chunk could possibly have. Assuming the worse-case scenario of a 3D
-   checkerboard pattern, then half the blocks would have all 6 faces exposed.
-*/
-#define MAX_QUADS ((CHUNK_VOLUME / 2) * 6)
-#define MAX_VERTS (MAX_QUADS * 4)
-#define MAX_INDICES (MAX_QUADS * 6)
-
 /* clang-format off */
 static const iVec3 FACE_VERTICES[DIRECTION_COUNT][4] = {
     [DIR_POSITIVE_X] = {
@@ -99,10 +94,17 @@ static const iVec3 AO_OFFSETS[DIRECTION_COUNT][4][3] = {
 };
 /* clang-format on */
 
+typedef struct Column_Masks Column_Masks;
+
 typedef struct Mesher {
     const Meshing_Data *data;
-    uint32_t *vertices;
-    uint32_t vertex_count;
+    const Column_Masks *masks;
+    uint64_t *quads;
+    uint32_t quad_count;
+    uint32_t quad_capacity;
+
+    /* Where the next quad of each face direction is written. */
+    uint32_t direction_cursors[DIRECTION_COUNT];
 } Mesher;
 
 static Block_Type get_block(const Mesher *mesher, iVec3 pos) {
@@ -128,37 +130,13 @@ static bool is_block_opaque(const Mesher *mesher, iVec3 pos) {
     return !is_block_transparent(mesher, pos);
 }
 
-static void push_vertex(Mesher *mesher, iVec3 pos, Direction dir, Texture_ID tex, uint8_t ao) {
-    /* Vertex format:
-     *  *-------------------*---------*---------------*------------*
-     *  |Data               |  size   | bit range     |  max value |
-     *  *-------------------*---------*---------------*------------*
-     *  |x                  |  6 bits | (bits 31..26) |     64     |
-     *  |y                  |  6 bits | (bits 26..20) |     64     |
-     *  |z                  |  6 bits | (bits 20..14) |     64     |
-     *  |direction          |  3 bits | (bits 14..11) |     8      |
-     *  |ambient occlusion  |  2 bits | (bits 11..9)  |     4      |
-     *  |texture id         |  9 bits | (bits  9..0)  |     512    |
-     *  *-------------------*---------*---------------*------------*
-     */
-
-    assert(pos.x < 64 && pos.y < 64 && pos.z < 64);
-    assert(dir < 8);
-    assert(ao < 4);
-    assert(tex < 512);
+static void push_quad(Mesher *mesher, const Quad *quad) {
+    Direction dir = quad->direction;
 
-    /* clang-format off */
-    uint32_t vert = ((uint32_t)pos.x << 26)   |
-                    ((uint32_t)pos.y << 20)   |
-                    ((uint32_t)pos.z << 14)   |
-                    ((uint32_t)dir << 11) |
-                    ((uint32_t)ao << 9)   |
-                    (uint32_t)tex;
-    /* clang-format on */
-
-    assert(mesher->vertex_count < MAX_VERTS);
-    mesher->vertices[mesher->vertex_count] = vert;
-    mesher->vertex_count++;
+    assert(mesher->direction_cursors[dir] < mesher->quad_capacity);
+    mesher->quads[mesher->direction_cursors[dir]] = encode_quad(quad);
+    mesher->direction_cursors[dir]++;
+    mesher->quad_count++;
 }
 
 static uint8_t vertex_ao(bool side_1, bool side_2, bool corner) {
@@ -169,7 +147,9 @@ static uint8_t vertex_ao(bool side_1, bool side_2, bool corner) {
     return 3 - (side_1 + side_2 + corner);
 }
 
-static void push_face(Mesher *mesher, iVec3 pos, Direction dir, Texture_ID tex) {
+/* Reference ambient occlusion, sampling each neighbor block directly. The mesher uses the lookup
+ * table built by meshing_init() instead, this is kept to check the table against. */
+static void sample_face_ao(const Mesher *mesher, iVec3 pos, Direction dir, uint8_t ao[4]) {
     for (int i = 0; i < 4; i++) {
         iVec3 side_1_sample = AO_OFFSETS[dir][i][0];
         iVec3 side_2_sample = AO_OFFSETS[dir][i][1];
@@ -178,11 +158,190 @@ static void push_face(Mesher *mesher, iVec3 pos, Direction dir, Texture_ID tex)
         bool side_1 = is_block_opaque(mesher, ivec3_add(pos, side_1_sample));
         bool side_2 = is_block_opaque(mesher, ivec3_add(pos, side_2_sample));
         bool corner = is_block_opaque(mesher, ivec3_add(pos, corner_sample));
-        uint8_t ao = vertex_ao(side_1, side_2, corner);
+        ao[i] = vertex_ao(side_1, side_2, corner);
+    }
+}
+
+/* Solidity and opacity are packed into 64-bit columns along each axis (a padded column of
+ * MESHING_DATA_SIZE bits fits in a single word), which turns face culling for a whole column into a
+ * shift and an AND. This gives an exact face count up front, so the quad buffer can be allocated
+ * at its final size.
+ *
+ * Axes are numbered X = 0, Y = 1, Z = 2. For a face normal along axis A, the in-plane axes are
+ * U = (A + 1) % 3 and V = (A + 2) % 3.
+ */
+
+static const int DIRECTION_AXIS[DIRECTION_COUNT] = {
+    [DIR_POSITIVE_X] = 0, [DIR_POSITIVE_Y] = 1, [DIR_POSITIVE_Z] = 2,
+    [DIR_NEGATIVE_X] = 0, [DIR_NEGATIVE_Y] = 1, [DIR_NEGATIVE_Z] = 2,
+};
+
+static const bool DIRECTION_IS_POSITIVE[DIRECTION_COUNT] = {
+    [DIR_POSITIVE_X] = true, [DIR_POSITIVE_Y] = true, [DIR_POSITIVE_Z] = true,
+};
+
+static int ivec3_component(iVec3 v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+struct Column_Masks {
+    /* Indexed by [axis][padded U coordinate][padded V coordinate], bit i is the block at padded
+     * coordinate i along the axis. */
+    uint64_t solid[3][MESHING_DATA_SIZE][MESHING_DATA_SIZE];
+    uint64_t opaque[3][MESHING_DATA_SIZE][MESHING_DATA_SIZE];
+};
+
+static void build_column_masks(const Meshing_Data *data, Column_Masks *masks) {
+    bool is_solid[BLOCK_TYPE_COUNT];
+    bool is_opaque[BLOCK_TYPE_COUNT];
+    for (Block_Type type = 0; type < BLOCK_TYPE_COUNT; type++) {
+        is_solid[type] = type != BLOCK_AIR;
+        is_opaque[type] = !get_block_properties(type)->is_transparent;
+    }
+
+    memset(masks, 0, sizeof(*masks));
+
+    size_t index = 0;
+    for (int z = 0; z < MESHING_DATA_SIZE; z++) {
+        for (int y = 0; y < MESHING_DATA_SIZE; y++) {
+            for (int x = 0; x < MESHING_DATA_SIZE; x++) {
+                Block_Type type = data->blocks[index++];
 
-        iVec3 vertex_pos = ivec3_add(pos, FACE_VERTICES[dir][i]);
-        push_vertex(mesher, vertex_pos, dir, tex, ao);
+                if (is_solid[type]) {
+                    masks->solid[0][y][z] |= (uint64_t)1 << x;
+                    masks->solid[1][z][x] |= (uint64_t)1 << y;
+                    masks->solid[2][x][y] |= (uint64_t)1 << z;
+                }
+
+                if (is_opaque[type]) {
+                    masks->opaque[0][y][z] |= (uint64_t)1 << x;
+                    masks->opaque[1][z][x] |= (uint64_t)1 << y;
+                    masks->opaque[2][x][y] |= (uint64_t)1 << z;
+                }
+            }
+        }
+    }
+}
+
+/* Returns the exposed faces of the column at (u, v), with bit i being the block at coordinate i
+ * along the normal. */
+static uint32_t get_exposed_faces(const Column_Masks *masks, Direction dir, int u, int v) {
+    int axis = DIRECTION_AXIS[dir];
+    uint64_t solid = masks->solid[axis][u + 1][v + 1];
+    uint64_t opaque = masks->opaque[axis][u + 1][v + 1];
+
+    /* A face is exposed if the block is solid and its neighbor along the normal is not opaque.
+     * Shift the neighbors onto the blocks, then drop the padding. */
+    uint64_t neighbors = DIRECTION_IS_POSITIVE[dir] ? (opaque >> 1) : (opaque << 1);
+    return (uint32_t)((solid & ~neighbors) >> 1);
+}
+
+static uint32_t count_exposed_faces(const Column_Masks *masks, Direction dir) {
+    uint32_t face_count = 0;
+
+    for (int u = 0; u < CHUNK_SIZE; u++) {
+        for (int v = 0; v < CHUNK_SIZE; v++) {
+            face_count += (uint32_t)popcount64(get_exposed_faces(masks, dir, u, v));
+        }
     }
+
+    return face_count;
+}
+
+/* Ambient occlusion from the opacity masks.
+ *
+ * All 12 samples of a face lie on the 8 blocks surrounding it in the plane in front of the face.
+ * Their opacity is gathered into an 8-bit pattern, and a per-direction table maps each pattern to
+ * the four 2-bit corner values, packed with corner i in bits 2i..2i+1.
+ *
+ * Bit k of the pattern is the neighbor at (du, dv), going through dv = -1, 0, 1 and then
+ * du = -1, 0, 1, skipping the face's own position.
+ */
+
+static uint8_t AO_TABLE[DIRECTION_COUNT][256];
+static bool is_ao_table_initialized;
+
+static int get_ao_neighbor_bit(int du, int dv) {
+    assert(du != 0 || dv != 0);
+
+    if (dv < 0) {
+        return du + 1;
+    } else if (dv == 0) {
+        return du < 0 ? 3 : 4;
+    } else {
+        return du + 6;
+    }
+}
+
+static uint32_t get_ao_neighbors(const Column_Masks *masks, Direction dir, int a, int u, int v) {
+    int axis = DIRECTION_AXIS[dir];
+    int u_axis = (axis + 1) % 3;
+
+    /* The columns along U are indexed by [padded V][padded normal coordinate], so each row of the
+     * plane in front of the face is a single column. Shifting by the unpadded u leaves the blocks
+     * at u - 1, u and u + 1 in the low 3 bits. */
+    int plane = a + 1 + (DIRECTION_IS_POSITIVE[dir] ? 1 : -1);
+    uint32_t below = (uint32_t)(masks->opaque[u_axis][v][plane] >> u) & 7;
+    uint32_t middle = (uint32_t)(masks->opaque[u_axis][v + 1][plane] >> u) & 7;
+    uint32_t above = (uint32_t)(masks->opaque[u_axis][v + 2][plane] >> u) & 7;
+
+    return below | (middle & 1) << 3 | (middle >> 2) << 4 | above << 5;
+}
+
+/* Returns the packed ambient occlusion of the face, corner i in bits 2i..2i+1. */
+static uint32_t get_face_ao(const Column_Masks *masks, Direction dir, int a, int u, int v) {
+    assert(is_ao_table_initialized);
+    return AO_TABLE[dir][get_ao_neighbors(masks, dir, a, u, v)];
+}
+
+void meshing_init(void) {
+    for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+        int axis = DIRECTION_AXIS[dir];
+        int u_axis = (axis + 1) % 3;
+        int v_axis = (axis + 2) % 3;
+
+        for (uint32_t pattern = 0; pattern < 256; pattern++) {
+            uint32_t packed = 0;
+
+            for (int i = 0; i < 4; i++) {
+                bool samples[3];
+                for (int j = 0; j < 3; j++) {
+                    iVec3 offset = AO_OFFSETS[dir][i][j];
+                    int bit = get_ao_neighbor_bit(ivec3_component(offset, u_axis),
+                                                  ivec3_component(offset, v_axis));
+                    samples[j] = (pattern >> bit) & 1;
+                }
+
+                packed |= (uint32_t)vertex_ao(samples[0], samples[1], samples[2]) << (i * 2);
+            }
+
+            AO_TABLE[dir][pattern] = (uint8_t)packed;
+        }
+    }
+
+    is_ao_table_initialized = true;
+}
+
+static void push_face(Mesher *mesher, iVec3 pos, Direction dir, Texture_ID tex) {
+    Quad quad = {
+        .position = pos,
+        .width = 1,
+        .height = 1,
+        .direction = dir,
+        .texture = tex,
+    };
+
+    int axis = DIRECTION_AXIS[dir];
+    int a = ivec3_component(pos, axis);
+    int u = ivec3_component(pos, (axis + 1) % 3);
+    int v = ivec3_component(pos, (axis + 2) % 3);
+
+    uint32_t ao = get_face_ao(mesher->masks, dir, a, u, v);
+    for (int i = 0; i < 4; i++) {
+        quad.ao[i] = (uint8_t)((ao >> (i * 2)) & 3);
+    }
+
+    push_quad(mesher, &quad);
 }
 
 static void mesh_block(Mesher *mesher, Block_Type type, iVec3 pos) {
@@ -197,17 +356,35 @@ static void mesh_block(Mesher *mesher, Block_Type type, iVec3 pos) {
     }
 }
 
-uint32_t *mesh_chunk(const Meshing_Data *data, uint32_t *vertex_count, Arena *arena) {
+void mesh_chunk(const Meshing_Data *data, Chunk_Mesh *mesh, Arena *arena) {
     assert(data != NULL);
-    assert(vertex_count != NULL);
+    assert(mesh != NULL);
     assert(arena != NULL);
 
+    *mesh = (Chunk_Mesh){0};
+
+    Column_Masks masks;
+    build_column_masks(data, &masks);
+
+    /* Every exposed face becomes exactly one quad, so the exact size of every direction's group
+     * of quads is known before meshing. */
     Mesher mesher = {
         .data = data,
-        .vertex_count = 0,
-        .vertices = ARENA_NEW_ARRAY(arena, uint32_t, MAX_VERTS),
+        .masks = &masks,
     };
 
+    for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+        mesher.direction_cursors[dir] = mesher.quad_capacity;
+        mesh->direction_quad_counts[dir] = count_exposed_faces(&masks, dir);
+        mesher.quad_capacity += mesh->direction_quad_counts[dir];
+    }
+
+    if (mesher.quad_capacity == 0) {
+        return;
+    }
+
+    mesher.quads = ARENA_NEW_ARRAY_UNINIT(arena, uint64_t, mesher.quad_capacity);
+
     for (int z = 0; z < CHUNK_SIZE; z++) {
         for (int y = 0; y < CHUNK_SIZE; y++) {
             for (int x = 0; x < CHUNK_SIZE; x++) {
@@ -221,21 +398,418 @@ uint32_t *mesh_chunk(const Meshing_Data *data, uint32_t *vertex_count, Arena *ar
         }
     }
 
-    *vertex_count = mesher.vertex_count;
-    return mesher.vertices;
+    assert(mesher.quad_count == mesher.quad_capacity);
+
+    mesh->quads = mesher.quads;
+    mesh->quad_count = mesher.quad_count;
+}
+
+/* Greedy meshing.
+ *
+ * The exposed faces are scattered into 32x32 bit planes, one per slice along the face normal, and
+ * merged into rectangles of faces that share a texture and ambient occlusion.
+ */
+
+typedef struct Face_Planes {
+    /* Indexed by [slice along the normal][V coordinate], bit i is the face at U coordinate i. */
+    uint32_t rows[CHUNK_SIZE][CHUNK_SIZE];
+
+    /* Texture (bits 8 and up) and packed ambient occlusion (low byte) of each face in the slice
+     * currently being merged. */
+    uint32_t keys[CHUNK_SIZE][CHUNK_SIZE];
+} Face_Planes;
+
+static iVec3 axis_position(int axis, int a, int u, int v) {
+    int p[3];
+    p[axis] = a;
+    p[(axis + 1) % 3] = u;
+    p[(axis + 2) % 3] = v;
+    return (iVec3){p[0], p[1], p[2]};
+}
+
+static void build_face_planes(const Column_Masks *masks, Direction dir, Face_Planes *planes) {
+    memset(planes->rows, 0, sizeof(planes->rows));
+
+    for (int u = 0; u < CHUNK_SIZE; u++) {
+        for (int v = 0; v < CHUNK_SIZE; v++) {
+            uint32_t faces = get_exposed_faces(masks, dir, u, v);
+
+            while (faces) {
+                int a = count_trailing_zeros32(faces);
+                faces &= faces - 1;
+
+                planes->rows[a][v] |= (uint32_t)1 << u;
+            }
+        }
+    }
+}
+
+/* Faces can only be merged along an axis if their ambient occlusion does not vary along it,
+ * otherwise the interpolated shading of the merged quad would differ from the individual faces. */
+static bool is_ao_constant_along(Direction dir, uint32_t key, int axis) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            iVec3 a = FACE_VERTICES[dir][i];
+            iVec3 b = FACE_VERTICES[dir][j];
+
+            bool differs_only_along_axis = true;
+            for (int k = 0; k < 3; k++) {
+                bool same = ivec3_component(a, k) == ivec3_component(b, k);
+                if (same == (k == axis)) {
+                    differs_only_along_axis = false;
+                }
+            }
+
+            if (differs_only_along_axis && ((key >> (i * 2)) & 3) != ((key >> (j * 2)) & 3)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void push_merged_quad(Mesher *mesher, iVec3 pos, int width, int height, Direction dir,
+                             uint32_t key) {
+    Quad quad = {
+        .position = pos,
+        .width = width,
+        .height = height,
+        .direction = dir,
+        .texture = (Texture_ID)(key >> 8),
+    };
+
+    for (int i = 0; i < 4; i++) {
+        quad.ao[i] = (uint8_t)((key >> (i * 2)) & 3);
+    }
+
+    push_quad(mesher, &quad);
+}
+
+static void compute_slice_keys(const Mesher *mesher, Face_Planes *planes, Direction dir, int a) {
+    int axis = DIRECTION_AXIS[dir];
+
+    for (int v = 0; v < CHUNK_SIZE; v++) {
+        uint32_t row = planes->rows[a][v];
+
+        while (row) {
+            int u = count_trailing_zeros32(row);
+            row &= row - 1;
+
+            iVec3 pos = axis_position(axis, a, u, v);
+            const Block_Properties *properties = get_block_properties(get_block(mesher, pos));
+
+            uint32_t ao = get_face_ao(mesher->masks, dir, a, u, v);
+            planes->keys[v][u] = (uint32_t)properties->textures[dir] << 8 | ao;
+        }
+    }
+}
+
+static void merge_slice(Mesher *mesher, Face_Planes *planes, Direction dir, int a) {
+    int axis = DIRECTION_AXIS[dir];
+    int u_axis = (axis + 1) % 3;
+    int v_axis = (axis + 2) % 3;
+
+    uint32_t *rows = planes->rows[a];
+
+    for (int v = 0; v < CHUNK_SIZE; v++) {
+        while (rows[v]) {
+            int u = count_trailing_zeros32(rows[v]);
+            uint32_t key = planes->keys[v][u];
+
+            int width = 1;
+            if (is_ao_constant_along(dir, key, u_axis)) {
+                while (u + width < CHUNK_SIZE && (rows[v] >> (u + width) & 1) &&
+                       planes->keys[v][u + width] == key) {
+                    width++;
+                }
+            }
+
+            uint32_t span = (width == 32 ? UINT32_MAX : (((uint32_t)1 << width) - 1)) << u;
+
+            int height = 1;
+            if (is_ao_constant_along(dir, key, v_axis)) {
+                while (v + height < CHUNK_SIZE && (rows[v + height] & span) == span) {
+                    bool keys_match = true;
+                    for (int i = 0; i < width; i++) {
+                        if (planes->keys[v + height][u + i] != key) {
+                            keys_match = false;
+                            break;
+                        }
+                    }
+
+                    if (!keys_match) {
+                        break;
+                    }
+
+                    height++;
+                }
+            }
+
+            for (int i = 0; i < height; i++) {
+                rows[v + i] &= ~span;
+            }
+
+            iVec3 pos = axis_position(axis, a, u, v);
+            push_merged_quad(mesher, pos, width, height, dir, key);
+        }
+    }
 }
 
-uint32_t *generate_index_buffer(uint32_t *index_count, Arena *arena) {
-    assert(index_count != NULL);
+void mesh_chunk_greedy(const Meshing_Data *data, Chunk_Mesh *mesh, Arena *arena) {
+    assert(data != NULL);
+    assert(mesh != NULL);
     assert(arena != NULL);
 
-    uint32_t *buffer = ARENA_NEW_ARRAY(arena, uint32_t, MAX_INDICES);
-    const uint32_t INDEX_PATTERN[] = {0, 1, 3, 1, 2, 3};
+    *mesh = (Chunk_Mesh){0};
+
+    Column_Masks masks;
+    build_column_masks(data, &masks);
+
+    /* Merging can only reduce the number of quads, so the face count is an upper bound. The
+     * unused tail is given back to the arena afterwards. */
+    Mesher mesher = {
+        .data = data,
+        .masks = &masks,
+    };
+
+    for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+        mesher.quad_capacity += count_exposed_faces(&masks, dir);
+    }
+
+    if (mesher.quad_capacity == 0) {
+        return;
+    }
+
+    mesher.quads = ARENA_NEW_ARRAY_UNINIT(arena, uint64_t, mesher.quad_capacity);
+
+    /* Directions are meshed one after the other, so each group starts where the previous one
+     * ended. */
+    Face_Planes planes;
+    for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+        uint32_t direction_start = mesher.quad_count;
+        mesher.direction_cursors[dir] = direction_start;
+
+        build_face_planes(&masks, dir, &planes);
 
-    for (uint32_t i = 0; i < MAX_INDICES; i++) {
-        buffer[i] = (i / 6) * 4 + INDEX_PATTERN[i % 6];
+        for (int a = 0; a < CHUNK_SIZE; a++) {
+            compute_slice_keys(&mesher, &planes, dir, a);
+            merge_slice(&mesher, &planes, dir, a);
+        }
+
+        mesh->direction_quad_counts[dir] = mesher.quad_count - direction_start;
     }
 
-    *index_count = MAX_INDICES;
-    return buffer;
+    arena_shrink(arena, mesher.quads, sizeof(uint64_t) * mesher.quad_count);
+
+    mesh->quads = mesher.quads;
+    mesh->quad_count = mesher.quad_count;
+}
+
+size_t count_ao_mismatches(const Meshing_Data *data) {
+    assert(data != NULL);
+
+    Column_Masks masks;
+    build_column_masks(data, &masks);
+
+    Mesher mesher = {
+        .data = data,
+        .masks = &masks,
+    };
+
+    size_t mismatch_count = 0;
+    for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+        int axis = DIRECTION_AXIS[dir];
+
+        for (int u = 0; u < CHUNK_SIZE; u++) {
+            for (int v = 0; v < CHUNK_SIZE; v++) {
+                uint32_t faces = get_exposed_faces(&masks, dir, u, v);
+
+                while (faces) {
+                    int a = count_trailing_zeros32(faces);
+                    faces &= faces - 1;
+
+                    uint8_t expected[4];
+                    sample_face_ao(&mesher, axis_position(axis, a, u, v), dir, expected);
+
+                    uint32_t ao = get_face_ao(&masks, dir, a, u, v);
+                    for (int i = 0; i < 4; i++) {
+                        if (((ao >> (i * 2)) & 3) != expected[i]) {
+                            mismatch_count++;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return mismatch_count;
+}
+
+const char *get_meshing_mode_name(Meshing_Mode mode) {
+    assert(mode >= 0 && mode < MESHING_MODE_COUNT);
+
+    switch (mode) {
+    case MESHING_MODE_NAIVE:
+        return "Naive";
+    case MESHING_MODE_GREEDY:
+        return "Greedy";
+    default:
+        return "Unknown";
+    }
+}
+
+void mesh_chunk_with_mode(const Meshing_Data *data, Meshing_Mode mode, Chunk_Mesh *mesh,
+                          Arena *arena) {
+    assert(mode >= 0 && mode < MESHING_MODE_COUNT);
+
+    if (mode == MESHING_MODE_GREEDY) {
+        mesh_chunk_greedy(data, mesh, arena);
+    } else {
+        mesh_chunk(data, mesh, arena);
+    }
+}
+
+uint64_t encode_quad(const Quad *quad) {
+    /* Quad record format:
+     *  *-------------------*---------*---------------*------------*
+     *  |Data               |  size   | bit range     |  max value |
+     *  *-------------------*---------*---------------*------------*
+     *  |x                  |  6 bits | (bits  0..5)  |     64     |
+     *  |y                  |  6 bits | (bits  6..11) |     64     |
+     *  |z                  |  6 bits | (bits 12..17) |     64     |
+     *  |width - 1          |  5 bits | (bits 18..22) |     32     |
+     *  |height - 1         |  5 bits | (bits 23..27) |     32     |
+     *  |direction          |  3 bits | (bits 28..30) |     8      |
+     *  |ambient occlusion  |  8 bits | (bits 32..39) |  4 x 4     |
+     *  |texture id         |  9 bits | (bits 40..48) |     512    |
+     *  *-------------------*---------*---------------*------------*
+     *
+     * The shader reads each record as a uvec2, with bits 0..31 in x and bits 32..63 in y. The
+     * ambient occlusion holds two bits per corner, corner i in bits 2i..2i+1.
+     */
+
+    assert(quad != NULL);
+    assert(quad->position.x >= 0 && quad->position.x < 64);
+    assert(quad->position.y >= 0 && quad->position.y < 64);
+    assert(quad->position.z >= 0 && quad->position.z < 64);
+    assert(quad->width >= 1 && quad->width <= 32);
+    assert(quad->height >= 1 && quad->height <= 32);
+    assert(quad->direction < 8);
+    assert(quad->texture < 512);
+
+    uint32_t ao = 0;
+    for (int i = 0; i < 4; i++) {
+        assert(quad->ao[i] < 4);
+        ao |= (uint32_t)quad->ao[i] << (i * 2);
+    }
+
+    /* clang-format off */
+    uint32_t low = ((uint32_t)quad->position.x)          |
+                   ((uint32_t)quad->position.y << 6)     |
+                   ((uint32_t)quad->position.z << 12)    |
+                   ((uint32_t)(quad->width - 1) << 18)   |
+                   ((uint32_t)(quad->height - 1) << 23)  |
+                   ((uint32_t)quad->direction << 28);
+
+    uint32_t high = ao | ((uint32_t)quad->texture << 8);
+    /* clang-format on */
+
+    return (uint64_t)high << 32 | low;
+}
+
+Quad decode_quad(uint64_t record) {
+    uint32_t low = (uint32_t)record;
+    uint32_t high = (uint32_t)(record >> 32);
+
+    Quad quad = {
+        .position =
+            {
+                (int)(low & 0x3F),
+                (int)((low >> 6) & 0x3F),
+                (int)((low >> 12) & 0x3F),
+            },
+        .width = (int)((low >> 18) & 0x1F) + 1,
+        .height = (int)((low >> 23) & 0x1F) + 1,
+        .direction = (Direction)((low >> 28) & 0x7),
+        .texture = (Texture_ID)((high >> 8) & 0x1FF),
+    };
+
+    for (int i = 0; i < 4; i++) {
+        quad.ao[i] = (uint8_t)((high >> (i * 2)) & 3);
+    }
+
+    return quad;
+}
+
+void get_quad_corners(const Quad *quad, iVec3 corners[4]) {
+    assert(quad != NULL);
+    assert(quad->direction >= 0 && quad->direction < DIRECTION_COUNT);
+
+    int axis = DIRECTION_AXIS[quad->direction];
+    iVec3 size = axis_position(axis, 1, quad->width, quad->height);
+
+    for (int i = 0; i < 4; i++) {
+        iVec3 corner = FACE_VERTICES[quad->direction][i];
+        corners[i] = (iVec3){
+            quad->position.x + corner.x * size.x,
+            quad->position.y + corner.y * size.y,
+            quad->position.z + corner.z * size.z,
+        };
+    }
+}
+
+/* Determines which face directions of a chunk can face the camera. Faces pointing along +X lie
+ * on planes at x > chunk_min.x and are only front facing from beyond their plane, so the whole
+ * +X group can be skipped when the camera is at or below chunk_min.x. Likewise for the other
+ * directions. */
+static void get_visible_directions(Vec3 chunk_min, Vec3 camera_position,
+                                   bool visible[DIRECTION_COUNT]) {
+    Vec3 chunk_max = vec3_add(chunk_min, (Vec3){CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE});
+
+    visible[DIR_POSITIVE_X] = camera_position.x > chunk_min.x;
+    visible[DIR_POSITIVE_Y] = camera_position.y > chunk_min.y;
+    visible[DIR_POSITIVE_Z] = camera_position.z > chunk_min.z;
+    visible[DIR_NEGATIVE_X] = camera_position.x < chunk_max.x;
+    visible[DIR_NEGATIVE_Y] = camera_position.y < chunk_max.y;
+    visible[DIR_NEGATIVE_Z] = camera_position.z < chunk_max.z;
+}
+
+void get_mesh_draw_ranges(const Chunk *chunk, Vec3 camera_position, Mesh_Draw_Ranges *ranges) {
+    assert(chunk != NULL);
+    assert(ranges != NULL);
+
+    *ranges = (Mesh_Draw_Ranges){0};
+
+    Vec3 position =
+        vec3_scale((Vec3){chunk->coord.x, chunk->coord.y, chunk->coord.z}, CHUNK_SIZE);
+
+    bool visible[DIRECTION_COUNT];
+    get_visible_directions(position, camera_position, visible);
+
+    size_t direction_start = chunk->mesh.start;
+    bool extends_previous = false;
+    for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
+        uint32_t quad_count = chunk->mesh_direction_sizes[dir];
+
+        if (!visible[dir] || quad_count == 0) {
+            ranges->culled_quad_count += quad_count;
+            extends_previous = extends_previous && quad_count == 0;
+            direction_start += quad_count;
+            continue;
+        }
+
+        if (extends_previous) {
+            ranges->counts[ranges->count - 1] += quad_count;
+        } else {
+            ranges->firsts[ranges->count] = direction_start;
+            ranges->counts[ranges->count] = quad_count;
+            ranges->count++;
+        }
+
+        extends_previous = true;
+        direction_start += quad_count;
+        ranges->drawn_quad_count += quad_count;
+    }
 }
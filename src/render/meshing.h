@@ -2,6 +2,7 @@
 #define MESHING_H
 
 #include "utils/arena.h"
+#include "utils/direction.h"
 #include "world/chunk.h"
 
 #define MESHING_DATA_SIZE (CHUNK_SIZE + 2)
@@ -11,7 +12,69 @@ typedef struct Meshing_Data {
     uint8_t blocks[MESHING_DATA_VOLUME];
 } Meshing_Data;
 
-uint32_t *mesh_chunk(const Meshing_Data *data, uint32_t *vertex_count, Arena *arena);
-uint32_t *generate_index_buffer(uint32_t *index_count, Arena *arena);
+/* A rectangle of faces, stored on the GPU as a single 64-bit record. For a face normal along
+ * axis A (X = 0, Y = 1, Z = 2), the quad covers `width` blocks along axis (A + 1) % 3 and `height`
+ * blocks along axis (A + 2) % 3, starting from the block at `position`. */
+typedef struct Quad {
+    iVec3 position;
+    int width;
+    int height;
+    Direction direction;
+    Texture_ID texture;
+
+    /* Ambient occlusion of each corner, in the order returned by get_quad_corners(). */
+    uint8_t ao[4];
+} Quad;
+
+typedef struct Chunk_Mesh {
+    /* Encoded with encode_quad(). */
+    uint64_t *quads;
+    uint32_t quad_count;
+
+    /* The quads are grouped by face direction, in Direction order, so that whole directions can be
+     * skipped when drawing. */
+    uint32_t direction_quad_counts[DIRECTION_COUNT];
+} Chunk_Mesh;
+
+/* The quads of a chunk's resident mesh to draw, as ranges of quad indices into the quad buffer. */
+typedef struct Mesh_Draw_Ranges {
+    size_t firsts[DIRECTION_COUNT];
+    size_t counts[DIRECTION_COUNT];
+    int count;
+
+    size_t drawn_quad_count;
+    size_t culled_quad_count;
+} Mesh_Draw_Ranges;
+
+typedef enum Meshing_Mode {
+    MESHING_MODE_NAIVE,
+    MESHING_MODE_GREEDY,
+
+    MESHING_MODE_COUNT,
+} Meshing_Mode;
+
+const char *get_meshing_mode_name(Meshing_Mode mode);
+
+/* Builds the lookup tables used by the meshers. Must be called once before any chunk is meshed. */
+void meshing_init(void);
+
+void mesh_chunk(const Meshing_Data *data, Chunk_Mesh *mesh, Arena *arena);
+void mesh_chunk_greedy(const Meshing_Data *data, Chunk_Mesh *mesh, Arena *arena);
+void mesh_chunk_with_mode(const Meshing_Data *data, Meshing_Mode mode, Chunk_Mesh *mesh,
+                          Arena *arena);
+
+uint64_t encode_quad(const Quad *quad);
+Quad decode_quad(uint64_t record);
+
+/* Returns the corner positions of the quad, relative to its chunk. */
+void get_quad_corners(const Quad *quad, iVec3 corners[4]);
+
+/* Skips the face directions of the chunk's mesh that can't face the camera, and merges visible
+ * directions that are next to each other in the mesh into one range. */
+void get_mesh_draw_ranges(const Chunk *chunk, Vec3 camera_position, Mesh_Draw_Ranges *ranges);
+
+/* Returns the number of exposed faces in the data whose table-based ambient occlusion differs from
+ * sampling the neighbor blocks one by one. Used to verify the mesher, should always be zero. */
+size_t count_ao_mismatches(const Meshing_Data *data);
 
 #endif /* MESHING_H */
@@ -1,3 +1,8 @@
+#ifndef _WIN32
+/* For MAP_ANONYMOUS, which isn't part of POSIX. */
+#define _DEFAULT_SOURCE
+#endif
+
 #include "arena.h"
 
 #include <assert.h>
@@ -60,7 +65,7 @@ static void free_reserved_memory(void *addr, size_t size) {
 
 #endif
 
-static bool is_power_of_two(uintptr_t align) {
+static inline bool is_power_of_two(uintptr_t align) {
     return align != 0 && (align & (align - 1)) == 0;
 }
 
@@ -94,7 +99,7 @@ void arena_destroy(Arena *arena) {
     *arena = (Arena){0};
 }
 
-void *arena_alloc_aligned(Arena *arena, size_t size, size_t align) {
+void *arena_alloc_aligned_uninit(Arena *arena, size_t size, size_t align) {
     assert(arena != NULL);
     if (size == 0) {
         return NULL;
@@ -131,6 +136,20 @@ void *arena_alloc_aligned(Arena *arena, size_t size, size_t align) {
 
     uint8_t *ptr = arena->base + offset;
     arena->offset = new_offset;
+
+    if (arena->offset > arena->peak_offset) {
+        arena->peak_offset = arena->offset;
+    }
+
+    return ptr;
+}
+
+void *arena_alloc_aligned(Arena *arena, size_t size, size_t align) {
+    void *ptr = arena_alloc_aligned_uninit(arena, size, align);
+    if (!ptr) {
+        return NULL;
+    }
+
     return memset(ptr, 0, size);
 }
 
@@ -138,6 +157,24 @@ void *arena_alloc(Arena *arena, size_t size) {
     return arena_alloc_aligned(arena, size, DEFAULT_ALIGNMENT);
 }
 
+void *arena_alloc_uninit(Arena *arena, size_t size) {
+    return arena_alloc_aligned_uninit(arena, size, DEFAULT_ALIGNMENT);
+}
+
+void arena_shrink(Arena *arena, void *ptr, size_t new_size) {
+    assert(arena != NULL);
+
+    if (!ptr) {
+        return;
+    }
+
+    /* Only the most recent allocation can be shrunk, as it is the only one at the top. */
+    size_t offset = (size_t)((uint8_t *)ptr - arena->base);
+    assert(offset + new_size <= arena->offset);
+
+    arena->offset = offset + new_size;
+}
+
 void arena_reset(Arena *arena) {
     assert(arena);
     arena->offset = 0;
@@ -1,9 +1,10 @@
 #ifndef ARENA_H
 #define ARENA_H
 
+#include <stdalign.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
-#include <stdalign.h>
 
 #define KIB_TO_BYTES(x) ((uint64_t)(x) << 10)
 #define MIB_TO_BYTES(x) ((uint64_t)(x) << 20)
@@ -15,12 +16,17 @@
 #define ARENA_NEW_ARRAY(arena, T, COUNT) \
     ((T *)arena_alloc((arena), sizeof(T) * (COUNT)))
 
+/* Like ARENA_NEW_ARRAY, but the memory is not zeroed. */
+#define ARENA_NEW_ARRAY_UNINIT(arena, T, COUNT) \
+    ((T *)arena_alloc_uninit((arena), sizeof(T) * (COUNT)))
+
 typedef struct Arena {
     uint8_t *base;
 
     size_t reserved_size;
     size_t committed_size;
     size_t offset;
+    size_t peak_offset;
 
     size_t page_size;
 } Arena;
@@ -30,6 +36,9 @@ void arena_destroy(Arena *arena);
 
 void *arena_alloc_aligned(Arena *arena, size_t size, size_t align);
 void *arena_alloc(Arena *arena, size_t size);
+void *arena_alloc_aligned_uninit(Arena *arena, size_t size, size_t align);
+void *arena_alloc_uninit(Arena *arena, size_t size);
+void arena_shrink(Arena *arena, void *ptr, size_t new_size);
 void arena_reset(Arena *arena);
 
 #endif /* ARENA_H */
@@ -0,0 +1,42 @@
+#ifndef BITS_H
+#define BITS_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Index of the lowest set bit. The value must not be zero. */
+static inline int count_trailing_zeros32(uint32_t value) {
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+static inline int count_trailing_zeros64(uint64_t value) {
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+static inline int popcount64(uint64_t value) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(value);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+#endif /* BITS_H */
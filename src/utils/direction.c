@@ -11,9 +11,23 @@ static const iVec3 DIRECTION_TABLE[DIRECTION_COUNT] = {
     [DIR_NEGATIVE_Y] = { 0, -1,  0},
     [DIR_NEGATIVE_Z] = { 0,  0, -1},
 };
+
+static const Direction OPPOSITE_TABLE[DIRECTION_COUNT] = {
+    [DIR_POSITIVE_X] = DIR_NEGATIVE_X,
+    [DIR_POSITIVE_Y] = DIR_NEGATIVE_Y,
+    [DIR_POSITIVE_Z] = DIR_NEGATIVE_Z,
+    [DIR_NEGATIVE_X] = DIR_POSITIVE_X,
+    [DIR_NEGATIVE_Y] = DIR_POSITIVE_Y,
+    [DIR_NEGATIVE_Z] = DIR_POSITIVE_Z,
+};
 /* clang-format on */
 
 iVec3 direction_to_ivec3(Direction direction) {
     assert(direction >= 0 && direction < DIRECTION_COUNT);
     return DIRECTION_TABLE[direction];
 }
+
+Direction get_opposite_direction(Direction direction) {
+    assert(direction >= 0 && direction < DIRECTION_COUNT);
+    return OPPOSITE_TABLE[direction];
+}
@@ -15,5 +15,6 @@ typedef enum Direction {
 } Direction;
 
 iVec3 direction_to_ivec3(Direction direction);
+Direction get_opposite_direction(Direction direction);
 
 #endif /* DIRECTION_H */
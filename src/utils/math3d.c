@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stddef.h>
 
 float to_radians(float degrees) {
     return degrees * (PI / 180.0f);
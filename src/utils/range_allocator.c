@@ -12,11 +12,11 @@ static bool are_ranges_adjacent(const Range *a, const Range *b) {
     return a->start + a->size == b->start;
 }
 
+/* Returns NULL if the pool is empty. */
 static Node *alloc_node(Range_Allocator *allocator, Range range) {
     Node *node = allocator->pool_head;
     if (!node) {
-        fprintf(stderr, "Range allocator is out of pool memory");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
     allocator->pool_head = allocator->pool_head->next;
@@ -80,8 +80,9 @@ void range_allocator_destroy(Range_Allocator *allocator) {
     allocator->free_list_head = NULL;
 }
 
-Range range_alloc(Range_Allocator *allocator, size_t size) {
+bool range_alloc(Range_Allocator *allocator, size_t size, Range *range) {
     assert(allocator != NULL);
+    assert(range != NULL);
     assert(size > 0);
 
     Node *node = allocator->free_list_head;
@@ -89,7 +90,7 @@ Range range_alloc(Range_Allocator *allocator, size_t size) {
 
     while (node) {
         if (node->range.size >= size) {
-            Range range = {node->range.start, size};
+            *range = (Range){node->range.start, size};
             node->range.start += size;
             node->range.size -= size;
 
@@ -98,14 +99,13 @@ Range range_alloc(Range_Allocator *allocator, size_t size) {
             }
 
             allocator->used += size;
-            return range;
+            return true;
         }
         prev = node;
         node = node->next;
     }
 
-    fprintf(stderr, "Out of free ranges");
-    exit(EXIT_FAILURE);
+    return false;
 }
 
 void range_free(Range_Allocator *allocator, Range range) {
@@ -120,14 +120,23 @@ void range_free(Range_Allocator *allocator, Range range) {
         node = node->next;
     }
 
-    Node *new = alloc_node(allocator, range);
-    free_list_insert(allocator, prev, new);
-
-    if (prev && are_ranges_adjacent(&prev->range, &new->range)) {
-        prev->range.size += new->range.size;
-        prev->next = new->next;
-        free_node(allocator, new);
+    /* Ranges next to a free range are merged into it, so only isolated ranges need a node. */
+    Node *new;
+    if (prev && are_ranges_adjacent(&prev->range, &range)) {
+        prev->range.size += range.size;
         new = prev;
+    } else if (node && are_ranges_adjacent(&range, &node->range)) {
+        node->range.start = range.start;
+        node->range.size += range.size;
+        new = node;
+    } else {
+        new = alloc_node(allocator, range);
+        if (!new) {
+            fprintf(stderr, "Range allocator is out of pool memory, losing a range\n");
+            return;
+        }
+
+        free_list_insert(allocator, prev, new);
     }
 
     if (new->next && are_ranges_adjacent(&new->range, &new->next->range)) {
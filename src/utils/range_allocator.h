@@ -29,7 +29,11 @@ typedef struct Range_Allocator {
 void range_allocator_create(Range_Allocator *Range_Allocator, size_t capacity);
 void range_allocator_destroy(Range_Allocator *Range_Allocator);
 
-Range range_alloc(Range_Allocator *Range_Allocator, size_t size);
+/* Returns false, leaving `range` untouched, if no free range is large enough. */
+bool range_alloc(Range_Allocator *Range_Allocator, size_t size, Range *range);
+
+/* If the range can't be merged with a neighboring free range and the node pool is empty, it is
+ * lost and stays counted as used. */
 void range_free(Range_Allocator *Range_Allocator, Range range);
 
 #endif /* RANGE_ALLOCATOR_H */
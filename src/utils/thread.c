@@ -0,0 +1,161 @@
+#include "thread.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    Thread *thread = param;
+    thread->fn(thread->user_data);
+    return 0;
+}
+
+bool thread_create(Thread *thread, Thread_Fn fn, void *user_data) {
+    assert(thread != NULL);
+    assert(fn != NULL);
+
+    thread->fn = fn;
+    thread->user_data = user_data;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void thread_join(Thread *thread) {
+    assert(thread != NULL);
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+void mutex_create(Mutex *mutex) {
+    InitializeCriticalSection(&mutex->handle);
+}
+
+void mutex_destroy(Mutex *mutex) {
+    DeleteCriticalSection(&mutex->handle);
+}
+
+void mutex_lock(Mutex *mutex) {
+    EnterCriticalSection(&mutex->handle);
+}
+
+void mutex_unlock(Mutex *mutex) {
+    LeaveCriticalSection(&mutex->handle);
+}
+
+void condition_variable_create(Condition_Variable *cond) {
+    InitializeConditionVariable(&cond->handle);
+}
+
+void condition_variable_destroy(Condition_Variable *cond) {
+    (void)cond;
+}
+
+void condition_variable_wait(Condition_Variable *cond, Mutex *mutex) {
+    SleepConditionVariableCS(&cond->handle, &mutex->handle, INFINITE);
+}
+
+void condition_variable_signal(Condition_Variable *cond) {
+    WakeConditionVariable(&cond->handle);
+}
+
+void condition_variable_broadcast(Condition_Variable *cond) {
+    WakeAllConditionVariable(&cond->handle);
+}
+
+size_t get_processor_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+void thread_yield(void) {
+    SwitchToThread();
+}
+
+int32_t atomic_add_i32(volatile int32_t *target, int32_t value) {
+    return (int32_t)InterlockedExchangeAdd((volatile LONG *)target, value) + value;
+}
+
+int32_t atomic_load_i32(volatile int32_t *target) {
+    /* Interlocked operations are full barriers. Adding zero is a load. */
+    return (int32_t)InterlockedExchangeAdd((volatile LONG *)target, 0);
+}
+
+#else
+#include <sched.h>
+#include <unistd.h>
+
+static void *thread_entry(void *param) {
+    Thread *thread = param;
+    thread->fn(thread->user_data);
+    return NULL;
+}
+
+bool thread_create(Thread *thread, Thread_Fn fn, void *user_data) {
+    assert(thread != NULL);
+    assert(fn != NULL);
+
+    thread->fn = fn;
+    thread->user_data = user_data;
+    return pthread_create(&thread->handle, NULL, thread_entry, thread) == 0;
+}
+
+void thread_join(Thread *thread) {
+    assert(thread != NULL);
+    pthread_join(thread->handle, NULL);
+}
+
+void mutex_create(Mutex *mutex) {
+    pthread_mutex_init(&mutex->handle, NULL);
+}
+
+void mutex_destroy(Mutex *mutex) {
+    pthread_mutex_destroy(&mutex->handle);
+}
+
+void mutex_lock(Mutex *mutex) {
+    pthread_mutex_lock(&mutex->handle);
+}
+
+void mutex_unlock(Mutex *mutex) {
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+void condition_variable_create(Condition_Variable *cond) {
+    pthread_cond_init(&cond->handle, NULL);
+}
+
+void condition_variable_destroy(Condition_Variable *cond) {
+    pthread_cond_destroy(&cond->handle);
+}
+
+void condition_variable_wait(Condition_Variable *cond, Mutex *mutex) {
+    pthread_cond_wait(&cond->handle, &mutex->handle);
+}
+
+void condition_variable_signal(Condition_Variable *cond) {
+    pthread_cond_signal(&cond->handle);
+}
+
+void condition_variable_broadcast(Condition_Variable *cond) {
+    pthread_cond_broadcast(&cond->handle);
+}
+
+size_t get_processor_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+void thread_yield(void) {
+    sched_yield();
+}
+
+int32_t atomic_add_i32(volatile int32_t *target, int32_t value) {
+    return __atomic_add_fetch(target, value, __ATOMIC_SEQ_CST);
+}
+
+int32_t atomic_load_i32(volatile int32_t *target) {
+    return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef void (*Thread_Fn)(void *user_data);
+
+typedef struct Thread {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    Thread_Fn fn;
+    void *user_data;
+} Thread;
+
+typedef struct Mutex {
+#ifdef _WIN32
+    CRITICAL_SECTION handle;
+#else
+    pthread_mutex_t handle;
+#endif
+} Mutex;
+
+typedef struct Condition_Variable {
+#ifdef _WIN32
+    CONDITION_VARIABLE handle;
+#else
+    pthread_cond_t handle;
+#endif
+} Condition_Variable;
+
+/* The thread must stay at the same address until it has been joined. */
+bool thread_create(Thread *thread, Thread_Fn fn, void *user_data);
+void thread_join(Thread *thread);
+
+void mutex_create(Mutex *mutex);
+void mutex_destroy(Mutex *mutex);
+void mutex_lock(Mutex *mutex);
+void mutex_unlock(Mutex *mutex);
+
+void condition_variable_create(Condition_Variable *cond);
+void condition_variable_destroy(Condition_Variable *cond);
+void condition_variable_wait(Condition_Variable *cond, Mutex *mutex);
+void condition_variable_signal(Condition_Variable *cond);
+void condition_variable_broadcast(Condition_Variable *cond);
+
+size_t get_processor_count(void);
+
+/* Lets another thread run on this core, for threads that poll. */
+void thread_yield(void);
+
+/* Adds `value` to `*target` as one atomic operation and returns the new value. Acts as a full
+ * memory barrier. */
+int32_t atomic_add_i32(volatile int32_t *target, int32_t value);
+
+/* Reads `*target` with acquire ordering, so writes made before another thread's atomic_add_i32()
+ * on it are visible afterwards. */
+int32_t atomic_load_i32(volatile int32_t *target);
+
+#endif /* THREAD_H */
@@ -0,0 +1,139 @@
+#include "thread_pool.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_JOB_CAPACITY 64
+
+static void worker_main(void *user_data) {
+    Thread_Pool_Worker *worker = user_data;
+    Thread_Pool *pool = worker->pool;
+
+    for (;;) {
+        mutex_lock(&pool->mutex);
+
+        while (pool->job_count == 0 && !pool->stopping) {
+            condition_variable_wait(&pool->job_available, &pool->mutex);
+        }
+
+        if (pool->job_count == 0) {
+            /* Stopping, and there is nothing left to do. */
+            mutex_unlock(&pool->mutex);
+            return;
+        }
+
+        Job job = pool->jobs[pool->job_head];
+        pool->job_head = (pool->job_head + 1) % pool->job_capacity;
+        pool->job_count--;
+
+        mutex_unlock(&pool->mutex);
+
+        job.fn(job.user_data, worker->index);
+    }
+}
+
+static void grow_job_queue(Thread_Pool *pool) {
+    size_t new_capacity = pool->job_capacity * 2;
+    Job *new_jobs = malloc(sizeof(Job) * new_capacity);
+    if (!new_jobs) {
+        fprintf(stderr, "Thread pool is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Unwrap the ring buffer into the start of the new allocation. */
+    for (size_t i = 0; i < pool->job_count; i++) {
+        new_jobs[i] = pool->jobs[(pool->job_head + i) % pool->job_capacity];
+    }
+
+    free(pool->jobs);
+    pool->jobs = new_jobs;
+    pool->job_capacity = new_capacity;
+    pool->job_head = 0;
+}
+
+bool thread_pool_create(Thread_Pool *pool, size_t thread_count) {
+    assert(pool != NULL);
+
+    *pool = (Thread_Pool){
+        .thread_count = thread_count,
+        .job_capacity = INITIAL_JOB_CAPACITY,
+    };
+
+    pool->jobs = malloc(sizeof(Job) * pool->job_capacity);
+    if (!pool->jobs) {
+        return false;
+    }
+
+    mutex_create(&pool->mutex);
+    condition_variable_create(&pool->job_available);
+
+    if (thread_count == 0) {
+        return true;
+    }
+
+    pool->workers = calloc(thread_count, sizeof(Thread_Pool_Worker));
+    if (!pool->workers) {
+        pool->thread_count = 0;
+        thread_pool_destroy(pool);
+        return false;
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        Thread_Pool_Worker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+
+        if (!thread_create(&worker->thread, worker_main, worker)) {
+            fprintf(stderr, "Failed to create worker thread %zu\n", i);
+            pool->thread_count = i;
+            thread_pool_destroy(pool);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void thread_pool_destroy(Thread_Pool *pool) {
+    assert(pool != NULL);
+
+    mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    condition_variable_broadcast(&pool->job_available);
+    mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < pool->thread_count; i++) {
+        thread_join(&pool->workers[i].thread);
+    }
+
+    condition_variable_destroy(&pool->job_available);
+    mutex_destroy(&pool->mutex);
+
+    free(pool->workers);
+    free(pool->jobs);
+    *pool = (Thread_Pool){0};
+}
+
+void thread_pool_submit(Thread_Pool *pool, Job_Fn fn, void *user_data) {
+    assert(pool != NULL);
+    assert(fn != NULL);
+
+    if (pool->thread_count == 0) {
+        fn(user_data, 0);
+        return;
+    }
+
+    mutex_lock(&pool->mutex);
+
+    if (pool->job_count == pool->job_capacity) {
+        grow_job_queue(pool);
+    }
+
+    size_t tail = (pool->job_head + pool->job_count) % pool->job_capacity;
+    pool->jobs[tail] = (Job){fn, user_data};
+    pool->job_count++;
+
+    condition_variable_signal(&pool->job_available);
+    mutex_unlock(&pool->mutex);
+}
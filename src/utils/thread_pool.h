@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "thread.h"
+
+/* worker_index is in [0, max(thread_count, 1)) and is stable for the lifetime of the pool, so
+ * jobs can use it to pick per-worker scratch memory. */
+typedef void (*Job_Fn)(void *user_data, size_t worker_index);
+
+typedef struct Job {
+    Job_Fn fn;
+    void *user_data;
+} Job;
+
+typedef struct Thread_Pool_Worker {
+    Thread thread;
+    struct Thread_Pool *pool;
+    size_t index;
+} Thread_Pool_Worker;
+
+typedef struct Thread_Pool {
+    Thread_Pool_Worker *workers;
+    size_t thread_count;
+
+    Mutex mutex;
+    Condition_Variable job_available;
+    bool stopping;
+
+    /* Ring buffer of pending jobs, grown on demand. */
+    Job *jobs;
+    size_t job_capacity;
+    size_t job_head;
+    size_t job_count;
+} Thread_Pool;
+
+/* A pool with zero threads runs every job inline in thread_pool_submit(). */
+bool thread_pool_create(Thread_Pool *pool, size_t thread_count);
+
+/* Runs all pending jobs to completion, then joins the threads. */
+void thread_pool_destroy(Thread_Pool *pool);
+
+void thread_pool_submit(Thread_Pool *pool, Job_Fn fn, void *user_data);
+
+#endif /* THREAD_POOL_H */
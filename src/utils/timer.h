@@ -0,0 +1,11 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+#define NS_PER_SECOND 1000000000ull
+
+/* Monotonic time in nanoseconds, safe to call from any thread. */
+uint64_t get_time_ns(void);
+
+#endif /* TIMER_H */
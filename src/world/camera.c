@@ -1,6 +1,7 @@
 #include "camera.h"
 
 #include <assert.h>
+#include <stddef.h>
 
 void camera_update(Camera *camera) {
     assert(camera != NULL);
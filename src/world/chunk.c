@@ -1,13 +1,628 @@
 #include "chunk.h"
 
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/thread.h"
+
+/* Expanding every possible byte of indices costs up to 2048 writes, so it is only worth it for
+ * large boxes. */
+#define MIN_BLOCKS_FOR_BYTE_TABLE 4096
+
+/* Index storage is reference counted so snapshots can share it, see chunk_snapshot(). A chunk's
+ * `indices` point at `words`. */
+typedef struct Index_Buffer {
+    volatile int32_t reference_count;
+    uint64_t words[];
+} Index_Buffer;
+
+static Index_Buffer *get_index_buffer(uint64_t *indices) {
+    return (Index_Buffer *)(void *)((char *)indices - offsetof(Index_Buffer, words));
+}
+
+static uint64_t *allocate_indices(size_t word_count, bool is_zeroed) {
+    size_t size = sizeof(Index_Buffer) + word_count * sizeof(uint64_t);
+    Index_Buffer *buffer = is_zeroed ? calloc(1, size) : malloc(size);
+    if (!buffer) {
+        fprintf(stderr, "Chunk is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    buffer->reference_count = 1;
+    return buffer->words;
+}
+
+/* Frees the storage once nothing else refers to it. Snapshots may be released on any thread. */
+static void release_indices(uint64_t *indices) {
+    if (!indices) {
+        return;
+    }
+
+    Index_Buffer *buffer = get_index_buffer(indices);
+    if (atomic_add_i32(&buffer->reference_count, -1) == 0) {
+        free(buffer);
+    }
+}
+
+static size_t get_word_count(const Chunk *chunk) {
+    return (size_t)CHUNK_VOLUME * chunk->bits_per_index / 64;
+}
+
+/* Copies the indices if a snapshot still shares them, so writes never show through to it. Only
+ * the chunk's own thread takes new snapshots, so storage that isn't shared stays that way. */
+static void make_indices_unique(Chunk *chunk) {
+    if (!chunk->indices) {
+        return;
+    }
+
+    Index_Buffer *buffer = get_index_buffer(chunk->indices);
+    if (atomic_load_i32(&buffer->reference_count) == 1) {
+        return;
+    }
+
+    size_t word_count = get_word_count(chunk);
+    uint64_t *copy = allocate_indices(word_count, false);
+    memcpy(copy, chunk->indices, word_count * sizeof(uint64_t));
+
+    release_indices(chunk->indices);
+    chunk->indices = copy;
+}
+
 static size_t get_index(iVec3 pos) {
     return (size_t)(pos.x + CHUNK_SIZE * (pos.y + CHUNK_SIZE * pos.z));
 }
 
+/* Index widths are powers of two, so an index never straddles two words. */
+static uint8_t get_bits_per_index(size_t palette_size) {
+    if (palette_size <= 1) {
+        return 0;
+    } else if (palette_size <= 2) {
+        return 1;
+    } else if (palette_size <= 4) {
+        return 2;
+    } else if (palette_size <= 16) {
+        return 4;
+    }
+
+    return 8;
+}
+
+static uint32_t read_index(const Chunk *chunk, size_t index) {
+    if (chunk->bits_per_index == 0) {
+        return 0;
+    }
+
+    size_t bit = index * chunk->bits_per_index;
+    uint64_t mask = (UINT64_C(1) << chunk->bits_per_index) - 1;
+    return (uint32_t)((chunk->indices[bit / 64] >> (bit % 64)) & mask);
+}
+
+static void write_index(Chunk *chunk, size_t index, uint32_t value) {
+    if (chunk->bits_per_index == 0) {
+        assert(value == 0);
+        return;
+    }
+
+    size_t bit = index * chunk->bits_per_index;
+    uint64_t mask = (UINT64_C(1) << chunk->bits_per_index) - 1;
+    uint64_t *word = &chunk->indices[bit / 64];
+
+    *word = (*word & ~(mask << (bit % 64))) | ((uint64_t)value << (bit % 64));
+}
+
+/* Drops the free palette slots and re-encodes every index at the narrowest width that fits the
+ * remaining types. */
+static void repack(Chunk *chunk) {
+    uint8_t new_palette[BLOCK_TYPE_COUNT];
+    uint8_t slot_remap[BLOCK_TYPE_COUNT];
+    size_t new_palette_size = 0;
+
+    for (size_t slot = 0; slot < chunk->palette_size; slot++) {
+        uint8_t type = chunk->palette[slot];
+        if (type == CHUNK_PALETTE_NONE) {
+            continue;
+        }
+
+        slot_remap[slot] = (uint8_t)new_palette_size;
+        new_palette[new_palette_size++] = type;
+    }
+
+    assert(new_palette_size == chunk->palette_type_count);
+
+    Chunk repacked = *chunk;
+    repacked.bits_per_index = get_bits_per_index(new_palette_size);
+    repacked.indices = NULL;
+
+    if (repacked.bits_per_index > 0) {
+        repacked.indices = allocate_indices(get_word_count(&repacked), true);
+
+        for (size_t i = 0; i < CHUNK_VOLUME; i++) {
+            write_index(&repacked, i, slot_remap[read_index(chunk, i)]);
+        }
+    }
+
+    release_indices(chunk->indices);
+    chunk->indices = repacked.indices;
+    chunk->bits_per_index = repacked.bits_per_index;
+
+    memset(chunk->palette_slots, CHUNK_PALETTE_NONE, sizeof(chunk->palette_slots));
+    for (size_t slot = 0; slot < new_palette_size; slot++) {
+        chunk->palette[slot] = new_palette[slot];
+        chunk->palette_slots[new_palette[slot]] = (uint8_t)slot;
+    }
+
+    chunk->palette_size = (uint8_t)new_palette_size;
+}
+
+static void add_to_palette(Chunk *chunk, Block_Type type) {
+    assert(chunk->palette_slots[type] == CHUNK_PALETTE_NONE);
+
+    chunk->palette_type_count++;
+
+    for (size_t slot = 0; slot < chunk->palette_size; slot++) {
+        if (chunk->palette[slot] == CHUNK_PALETTE_NONE) {
+            chunk->palette[slot] = (uint8_t)type;
+            chunk->palette_slots[type] = (uint8_t)slot;
+            return;
+        }
+    }
+
+    uint8_t slot = chunk->palette_size++;
+    chunk->palette[slot] = (uint8_t)type;
+    chunk->palette_slots[type] = slot;
+
+    if (chunk->palette_size > (1u << chunk->bits_per_index)) {
+        repack(chunk);
+    }
+}
+
+static void remove_from_palette(Chunk *chunk, Block_Type type) {
+    assert(chunk->palette_slots[type] != CHUNK_PALETTE_NONE);
+
+    chunk->palette[chunk->palette_slots[type]] = CHUNK_PALETTE_NONE;
+    chunk->palette_slots[type] = CHUNK_PALETTE_NONE;
+    chunk->palette_type_count--;
+
+    if (get_bits_per_index(chunk->palette_type_count) < chunk->bits_per_index) {
+        repack(chunk);
+    }
+}
+
+void chunk_init(Chunk *chunk, iVec3 coord) {
+    assert(chunk != NULL);
+
+    *chunk = (Chunk){
+        .coord = coord,
+        .palette_size = 1,
+        .palette_type_count = 1,
+    };
+
+    memset(chunk->palette_slots, CHUNK_PALETTE_NONE, sizeof(chunk->palette_slots));
+    chunk->palette[0] = BLOCK_AIR;
+    chunk->palette_slots[BLOCK_AIR] = 0;
+    chunk->block_counts[BLOCK_AIR] = CHUNK_VOLUME;
+}
+
+void chunk_destroy(Chunk *chunk) {
+    assert(chunk != NULL);
+
+    release_indices(chunk->indices);
+    chunk->indices = NULL;
+}
+
+void chunk_snapshot(const Chunk *chunk, Chunk *snapshot) {
+    assert(chunk != NULL);
+    assert(snapshot != NULL);
+
+    *snapshot = *chunk;
+    if (chunk->indices) {
+        atomic_add_i32(&get_index_buffer(chunk->indices)->reference_count, 1);
+    }
+}
+
 Block_Type chunk_get_block_unsafe(const Chunk *chunk, iVec3 pos) {
-    return chunk->blocks[get_index(pos)];
+    return chunk->palette[read_index(chunk, get_index(pos))];
 }
 
 void chunk_set_block_unsafe(Chunk *chunk, iVec3 pos, Block_Type new_block) {
-    chunk->blocks[get_index(pos)] = new_block;
+    size_t index = get_index(pos);
+    Block_Type old_block = chunk->palette[read_index(chunk, index)];
+    if (old_block == new_block) {
+        return;
+    }
+
+    if (chunk->palette_slots[new_block] == CHUNK_PALETTE_NONE) {
+        add_to_palette(chunk, new_block);
+    }
+
+    make_indices_unique(chunk);
+    write_index(chunk, index, chunk->palette_slots[new_block]);
+
+    assert(chunk->block_counts[old_block] > 0);
+    chunk->block_counts[old_block]--;
+    chunk->block_counts[new_block]++;
+
+    if (chunk->block_counts[old_block] == 0) {
+        remove_from_palette(chunk, old_block);
+    }
+}
+
+static void set_uniform(Chunk *chunk, Block_Type type) {
+    release_indices(chunk->indices);
+    chunk->indices = NULL;
+    chunk->bits_per_index = 0;
+
+    memset(chunk->palette_slots, CHUNK_PALETTE_NONE, sizeof(chunk->palette_slots));
+    memset(chunk->block_counts, 0, sizeof(chunk->block_counts));
+    chunk->palette[0] = (uint8_t)type;
+    chunk->palette_slots[type] = 0;
+    chunk->palette_size = 1;
+    chunk->palette_type_count = 1;
+    chunk->block_counts[type] = CHUNK_VOLUME;
+}
+
+/* Sets `count` consecutive indices starting at `start` to `slot` a word at a time, and adds how
+ * many of them held each slot before to `old_slot_counts`. */
+static void fill_run(Chunk *chunk, size_t start, size_t count, uint32_t slot,
+                     uint32_t *old_slot_counts) {
+    size_t bits = chunk->bits_per_index;
+    uint64_t index_mask = (UINT64_C(1) << bits) - 1;
+    uint64_t pattern = (uint64_t)slot * (UINT64_MAX / index_mask);
+
+    size_t bit = start * bits;
+    size_t end_bit = (start + count) * bits;
+    while (bit < end_bit) {
+        uint64_t *word = &chunk->indices[bit / 64];
+        size_t shift = bit % 64;
+        size_t bit_count = 64 - shift < end_bit - bit ? 64 - shift : end_bit - bit;
+        uint64_t mask = bit_count == 64 ? UINT64_MAX : ((UINT64_C(1) << bit_count) - 1) << shift;
+
+        if ((*word & mask) == (pattern & mask)) {
+            old_slot_counts[slot] += (uint32_t)(bit_count / bits);
+        } else {
+            for (size_t i = shift; i < shift + bit_count; i += bits) {
+                old_slot_counts[(*word >> i) & index_mask]++;
+            }
+        }
+
+        *word = (*word & ~mask) | (pattern & mask);
+        bit += bit_count;
+    }
+}
+
+bool chunk_fill_box_unsafe(Chunk *chunk, iVec3 min, iVec3 max, Block_Type type) {
+    assert(chunk != NULL);
+
+    size_t volume = (size_t)(max.x - min.x) * (size_t)(max.y - min.y) * (size_t)(max.z - min.z);
+    if (volume == 0 || chunk->block_counts[type] == CHUNK_VOLUME) {
+        return false;
+    }
+
+    if (volume == CHUNK_VOLUME) {
+        set_uniform(chunk, type);
+        return true;
+    }
+
+    if (chunk->palette_slots[type] == CHUNK_PALETTE_NONE) {
+        add_to_palette(chunk, type);
+    }
+    uint32_t slot = chunk->palette_slots[type];
+    make_indices_unique(chunk);
+
+    /* Whole rows and whole slices are contiguous in the indices, so they are filled as one run. */
+    uint32_t old_slot_counts[BLOCK_TYPE_COUNT] = {0};
+    size_t row_length = (size_t)(max.x - min.x);
+    bool has_whole_rows = row_length == CHUNK_SIZE;
+    bool has_whole_slices = has_whole_rows && max.y - min.y == CHUNK_SIZE;
+
+    if (has_whole_slices) {
+        fill_run(chunk, get_index((iVec3){0, 0, min.z}), volume, slot, old_slot_counts);
+    } else {
+        for (int z = min.z; z < max.z; z++) {
+            if (has_whole_rows) {
+                size_t count = CHUNK_SIZE * (size_t)(max.y - min.y);
+                fill_run(chunk, get_index((iVec3){0, min.y, z}), count, slot, old_slot_counts);
+                continue;
+            }
+
+            for (int y = min.y; y < max.y; y++) {
+                fill_run(chunk, get_index((iVec3){min.x, y, z}), row_length, slot,
+                         old_slot_counts);
+            }
+        }
+    }
+
+    if (old_slot_counts[slot] == volume) {
+        if (chunk->block_counts[type] == 0) {
+            remove_from_palette(chunk, type);
+        }
+        return false;
+    }
+
+    /* Types that were entirely overwritten leave the palette, which may narrow the indices. */
+    uint8_t old_palette[BLOCK_TYPE_COUNT];
+    size_t old_palette_size = chunk->palette_size;
+    memcpy(old_palette, chunk->palette, old_palette_size);
+
+    for (size_t i = 0; i < old_palette_size; i++) {
+        if (old_palette[i] != CHUNK_PALETTE_NONE) {
+            chunk->block_counts[old_palette[i]] -= (uint16_t)old_slot_counts[i];
+        }
+    }
+    chunk->block_counts[type] += (uint16_t)volume;
+
+    for (size_t i = 0; i < old_palette_size; i++) {
+        Block_Type old_type = old_palette[i];
+        if (old_type != CHUNK_PALETTE_NONE && chunk->block_counts[old_type] == 0) {
+            remove_from_palette(chunk, old_type);
+        }
+    }
+
+    return true;
+}
+
+bool chunk_replace_in_box_unsafe(Chunk *chunk, iVec3 min, iVec3 max, Block_Type from,
+                                 Block_Type to) {
+    assert(chunk != NULL);
+
+    if (from == to || chunk->block_counts[from] == 0 || min.x >= max.x || min.y >= max.y ||
+        min.z >= max.z) {
+        return false;
+    }
+
+    /* Replacing a type throughout the chunk with one it doesn't have yet only renames the palette
+     * entry. */
+    bool is_whole_chunk = min.x == 0 && min.y == 0 && min.z == 0 && max.x == CHUNK_SIZE &&
+                          max.y == CHUNK_SIZE && max.z == CHUNK_SIZE;
+    if (is_whole_chunk && chunk->palette_slots[to] == CHUNK_PALETTE_NONE) {
+        uint8_t slot = chunk->palette_slots[from];
+        chunk->palette[slot] = (uint8_t)to;
+        chunk->palette_slots[to] = slot;
+        chunk->palette_slots[from] = CHUNK_PALETTE_NONE;
+        chunk->block_counts[to] = chunk->block_counts[from];
+        chunk->block_counts[from] = 0;
+        return true;
+    }
+
+    if (chunk->palette_slots[to] == CHUNK_PALETTE_NONE) {
+        add_to_palette(chunk, to);
+    }
+
+    uint32_t from_slot = chunk->palette_slots[from];
+    uint32_t to_slot = chunk->palette_slots[to];
+    make_indices_unique(chunk);
+
+    uint16_t replaced_count = 0;
+    for (int z = min.z; z < max.z; z++) {
+        for (int y = min.y; y < max.y; y++) {
+            size_t row_start = get_index((iVec3){0, y, z});
+
+            for (int x = min.x; x < max.x; x++) {
+                if (read_index(chunk, row_start + (size_t)x) == from_slot) {
+                    write_index(chunk, row_start + (size_t)x, to_slot);
+                    replaced_count++;
+                }
+            }
+        }
+    }
+
+    chunk->block_counts[from] -= replaced_count;
+    chunk->block_counts[to] += replaced_count;
+
+    if (chunk->block_counts[to] == 0) {
+        remove_from_palette(chunk, to);
+    }
+    if (chunk->block_counts[from] == 0) {
+        remove_from_palette(chunk, from);
+    }
+
+    return replaced_count > 0;
+}
+
+void chunk_set_all_blocks_unsafe(Chunk *chunk, const uint8_t *blocks) {
+    assert(chunk != NULL);
+    assert(blocks != NULL);
+
+    /* Counting into four histograms keeps runs of the same type from waiting on each other's
+     * increments. */
+    uint32_t counts[4][BLOCK_TYPE_COUNT] = {{0}};
+    for (size_t i = 0; i < CHUNK_VOLUME; i += 4) {
+        counts[0][blocks[i]]++;
+        counts[1][blocks[i + 1]]++;
+        counts[2][blocks[i + 2]]++;
+        counts[3][blocks[i + 3]]++;
+    }
+
+    /* Build the final palette up front, so the indices are only packed once. */
+    memset(chunk->palette_slots, CHUNK_PALETTE_NONE, sizeof(chunk->palette_slots));
+    chunk->palette_size = 0;
+    for (Block_Type type = 0; type < BLOCK_TYPE_COUNT; type++) {
+        uint32_t count = counts[0][type] + counts[1][type] + counts[2][type] + counts[3][type];
+        chunk->block_counts[type] = (uint16_t)count;
+
+        if (count > 0) {
+            chunk->palette_slots[type] = chunk->palette_size;
+            chunk->palette[chunk->palette_size++] = (uint8_t)type;
+        }
+    }
+
+    chunk->palette_type_count = chunk->palette_size;
+    chunk->bits_per_index = get_bits_per_index(chunk->palette_size);
+
+    release_indices(chunk->indices);
+    chunk->indices = NULL;
+
+    int bits = chunk->bits_per_index;
+    if (bits == 0) {
+        return;
+    }
+
+    size_t word_count = get_word_count(chunk);
+    chunk->indices = allocate_indices(word_count, false);
+
+    /* The input is in the same order as the indices, so each word is packed in a register. */
+    size_t blocks_per_word = (size_t)(64 / bits);
+    for (size_t word = 0; word < word_count; word++) {
+        uint64_t packed = 0;
+        for (size_t i = 0; i < blocks_per_word; i++) {
+            packed |= (uint64_t)chunk->palette_slots[*blocks++] << (i * (size_t)bits);
+        }
+
+        chunk->indices[word] = packed;
+    }
+}
+
+/* Reads each block's index on its own. Called with a constant width, so the shifts and masks are
+ * resolved at compile time. */
+static inline void decode_blocks(const Chunk *chunk, int bits, iVec3 min, iVec3 max, uint8_t *out,
+                                 size_t row_stride, size_t slice_stride) {
+    uint64_t mask = (UINT64_C(1) << bits) - 1;
+
+    for (int z = min.z; z < max.z; z++) {
+        for (int y = min.y; y < max.y; y++) {
+            size_t offset = (size_t)(y - min.y) * row_stride + (size_t)(z - min.z) * slice_stride;
+            uint8_t *row = &out[offset];
+
+            for (int x = min.x; x < max.x; x++) {
+                size_t bit = get_index((iVec3){x, y, z}) * (size_t)bits;
+                uint64_t slot = (chunk->indices[bit / 64] >> (bit % 64)) & mask;
+                row[x - min.x] = chunk->palette[slot];
+            }
+        }
+    }
+}
+
+/* Decodes whole rows a byte of indices at a time. Every byte holds 8 / bits blocks, so each
+ * possible byte is expanded to its blocks up front. */
+static inline void decode_rows(const Chunk *chunk, int bits, iVec3 min, iVec3 max, uint8_t *out,
+                               size_t row_stride, size_t slice_stride) {
+    assert(min.x == 0 && max.x == CHUNK_SIZE);
+
+    enum { MAX_BLOCKS_PER_BYTE = 8 };
+    size_t blocks_per_byte = (size_t)(8 / bits);
+    uint32_t mask = (1u << bits) - 1;
+
+    uint8_t byte_blocks[256][MAX_BLOCKS_PER_BYTE];
+    for (uint32_t byte = 0; byte < 256; byte++) {
+        for (size_t i = 0; i < blocks_per_byte; i++) {
+            uint32_t slot = (byte >> (i * (size_t)bits)) & mask;
+            byte_blocks[byte][i] = slot < chunk->palette_size ? chunk->palette[slot] : BLOCK_AIR;
+        }
+    }
+
+    for (int z = min.z; z < max.z; z++) {
+        for (int y = min.y; y < max.y; y++) {
+            size_t offset = (size_t)(y - min.y) * row_stride + (size_t)(z - min.z) * slice_stride;
+            uint8_t *row = &out[offset];
+            size_t bit = get_index((iVec3){0, y, z}) * (size_t)bits;
+
+            for (size_t x = 0; x < CHUNK_SIZE; x += blocks_per_byte, bit += 8) {
+                uint32_t byte = (uint32_t)(chunk->indices[bit / 64] >> (bit % 64)) & 0xFF;
+                memcpy(&row[x], byte_blocks[byte], blocks_per_byte);
+            }
+        }
+    }
+}
+
+static inline void decode(const Chunk *chunk, int bits, iVec3 min, iVec3 max, uint8_t *out,
+                          size_t row_stride, size_t slice_stride) {
+    bool is_whole_rows = min.x == 0 && max.x == CHUNK_SIZE;
+    size_t block_count =
+        (size_t)(max.x - min.x) * (size_t)(max.y - min.y) * (size_t)(max.z - min.z);
+
+    if (is_whole_rows && block_count >= MIN_BLOCKS_FOR_BYTE_TABLE) {
+        decode_rows(chunk, bits, min, max, out, row_stride, slice_stride);
+    } else {
+        decode_blocks(chunk, bits, min, max, out, row_stride, slice_stride);
+    }
+}
+
+void chunk_decode_unsafe(const Chunk *chunk, iVec3 min, iVec3 max, uint8_t *out,
+                         size_t row_stride, size_t slice_stride) {
+    assert(chunk != NULL);
+    assert(out != NULL);
+    assert(min.x >= 0 && min.y >= 0 && min.z >= 0);
+    assert(max.x <= CHUNK_SIZE && max.y <= CHUNK_SIZE && max.z <= CHUNK_SIZE);
+
+    switch (chunk->bits_per_index) {
+    case 0:
+        for (int z = min.z; z < max.z; z++) {
+            for (int y = min.y; y < max.y; y++) {
+                size_t offset =
+                    (size_t)(y - min.y) * row_stride + (size_t)(z - min.z) * slice_stride;
+                memset(&out[offset], chunk->palette[0], (size_t)(max.x - min.x));
+            }
+        }
+        break;
+    case 1:
+        decode(chunk, 1, min, max, out, row_stride, slice_stride);
+        break;
+    case 2:
+        decode(chunk, 2, min, max, out, row_stride, slice_stride);
+        break;
+    case 4:
+        decode(chunk, 4, min, max, out, row_stride, slice_stride);
+        break;
+    case 8:
+        decode(chunk, 8, min, max, out, row_stride, slice_stride);
+        break;
+    default:
+        assert(false && "Invalid index width");
+        break;
+    }
+}
+
+size_t chunk_get_memory_size(const Chunk *chunk) {
+    assert(chunk != NULL);
+
+    return sizeof(Chunk) + (size_t)CHUNK_VOLUME * chunk->bits_per_index / 8;
+}
+
+bool chunk_is_uniform(const Chunk *chunk, Block_Type *type) {
+    assert(chunk != NULL);
+
+    /* A single type is always packed down to zero bits, in palette slot 0. */
+    if (chunk->bits_per_index != 0) {
+        return false;
+    }
+
+    assert(chunk->block_counts[chunk->palette[0]] == CHUNK_VOLUME);
+    if (type) {
+        *type = chunk->palette[0];
+    }
+    return true;
+}
+
+bool chunk_is_face_opaque(const Chunk *chunk, Direction face) {
+    assert(chunk != NULL);
+
+    Block_Type uniform_type;
+    if (chunk_is_uniform(chunk, &uniform_type)) {
+        return !get_block_properties(uniform_type)->is_transparent;
+    }
+
+    /* The face lies at the minimum or maximum coordinate along the face normal. */
+    iVec3 normal = direction_to_ivec3(face);
+    int fixed = (normal.x + normal.y + normal.z) > 0 ? CHUNK_SIZE - 1 : 0;
+
+    for (int v = 0; v < CHUNK_SIZE; v++) {
+        for (int u = 0; u < CHUNK_SIZE; u++) {
+            iVec3 pos;
+            if (normal.x != 0) {
+                pos = (iVec3){fixed, u, v};
+            } else if (normal.y != 0) {
+                pos = (iVec3){u, fixed, v};
+            } else {
+                pos = (iVec3){u, v, fixed};
+            }
+
+            if (get_block_properties(chunk_get_block_unsafe(chunk, pos))->is_transparent) {
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
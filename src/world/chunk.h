@@ -1,6 +1,7 @@
 #ifndef CHUNK_H
 #define CHUNK_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "utils/math3d.h"
@@ -10,16 +11,119 @@
 #define CHUNK_SIZE 32
 #define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
 
+/* Marks a palette slot that no block refers to, and block types that aren't in the palette. */
+#define CHUNK_PALETTE_NONE UINT8_MAX
+
 typedef struct Chunk {
     iVec3 coord;
 
-    uint8_t blocks[CHUNK_VOLUME];
-    bool in_dirty_list;
+    /* Blocks are stored as indices into a palette of the types present in the chunk, packed
+     * bits_per_index (0, 1, 2, 4 or 8) bits at a time in block index order. A chunk of a single
+     * type has no indices at all. The storage is repacked whenever the palette outgrows the index
+     * width, or shrinks enough to fit a narrower one.
+     *
+     * The indices may be shared with snapshots, and are copied by the first write while they
+     * are. */
+    uint64_t *indices;
+    uint8_t bits_per_index;
+
+    /* Slots freed by a type disappearing from the chunk are reused before the palette grows. */
+    uint8_t palette[BLOCK_TYPE_COUNT];
+    uint8_t palette_size;
+    uint8_t palette_type_count;
+
+    /* Palette slot of each block type, or CHUNK_PALETTE_NONE. */
+    uint8_t palette_slots[BLOCK_TYPE_COUNT];
+
+    /* Number of blocks of each type, kept up to date by chunk_set_block_unsafe(). */
+    uint16_t block_counts[BLOCK_TYPE_COUNT];
+
+    bool in_dirty_queue;
+    size_t dirty_queue_index;
+
+    /* Used by the world while a batch of edits is applied: set once the chunk is in the batch,
+     * and which of the 27 chunks around it, itself included, the edits reached. */
+    bool in_edit_batch;
+    uint32_t edit_neighbor_mask;
+
+    /* Maintained by the world for its residency budgets: the world tick the chunk was last used
+     * on, the bytes it was last counted as using, and how many of those were its mesh. */
+    uint64_t last_access;
+    size_t resident_bytes;
+    size_t resident_mesh_bytes;
+
+    /* Set when the blocks are edited after the chunk was generated or loaded, so that only edited
+     * chunks are saved. */
+    bool is_modified;
+
+    /* Set once the chunk has been edited, or when it was loaded from storage, which only holds
+     * edited chunks. Features are never placed into these chunks, so edits to them stick. */
+    bool has_edits;
+
+    /* Maintained by the world for the population stage: how many of the 26 chunks around this one
+     * are loaded, and whether this chunk has placed its features yet. */
+    uint8_t loaded_neighbor_count;
+    bool is_populated;
+
+    /* Which of the 27 chunks around this one, itself included, have placed their features in it
+     * since it was generated, as bit (x + 1) + 3 * ((y + 1) + 3 * (z + 1)) for offset (x, y, z).
+     * Journaled before the chunk's first edit. */
+    uint32_t feature_sources;
+
+    /* Incremented every time the chunk is marked dirty, so that meshes built from an older state
+     * of the chunk can be recognized as stale. */
+    uint32_t version;
 
+    /* In quads, see encode_quad(). */
     Range mesh;
+
+    /* Size of each face direction's sub-range of the mesh, which are stored back to back in
+     * Direction order. */
+    uint32_t mesh_direction_sizes[DIRECTION_COUNT];
 } Chunk;
 
+/* Resets the chunk to all air at the given coordinate. A chunk that was already initialized must
+ * be destroyed first. */
+void chunk_init(Chunk *chunk, iVec3 coord);
+
+/* Frees the chunk's block storage, or releases the snapshot's reference to it. */
+void chunk_destroy(Chunk *chunk);
+
+/* Copies the chunk into `snapshot`, sharing its block storage rather than copying it. The
+ * snapshot keeps the blocks as they are now however the chunk is edited later, and can be read on
+ * any thread, without locks, until it is destroyed with chunk_destroy(). Snapshots must only be
+ * taken on the thread that edits the chunk. */
+void chunk_snapshot(const Chunk *chunk, Chunk *snapshot);
+
 Block_Type chunk_get_block_unsafe(const Chunk *chunk, iVec3 pos);
 void chunk_set_block_unsafe(Chunk *chunk, iVec3 pos, Block_Type new_block);
 
+/* Replaces every block of the chunk. `blocks` holds CHUNK_VOLUME block types in order of
+ * increasing x, then y, then z. */
+void chunk_set_all_blocks_unsafe(Chunk *chunk, const uint8_t *blocks);
+
+/* Decodes the blocks in the box from `min` (inclusive) to `max` (exclusive), writing the block at
+ * min + (x, y, z) to out[x + y * row_stride + z * slice_stride]. Much faster than reading the
+ * blocks one at a time, which is how the mesher gathers its input. */
+void chunk_decode_unsafe(const Chunk *chunk, iVec3 min, iVec3 max, uint8_t *out,
+                         size_t row_stride, size_t slice_stride);
+
+/* Sets every block in the box from `min` (inclusive) to `max` (exclusive), which must lie inside
+ * the chunk. Whole rows and slices are written a word of indices at a time. Returns true if any
+ * block changed. */
+bool chunk_fill_box_unsafe(Chunk *chunk, iVec3 min, iVec3 max, Block_Type type);
+
+/* Like chunk_fill_box_unsafe(), but only replaces blocks of type `from`. */
+bool chunk_replace_in_box_unsafe(Chunk *chunk, iVec3 min, iVec3 max, Block_Type from,
+                                 Block_Type to);
+
+/* Bytes of memory used by the chunk and its block storage, not counting its mesh. */
+size_t chunk_get_memory_size(const Chunk *chunk);
+
+/* Returns true if every block in the chunk has the same type, and stores that type in `type`. */
+bool chunk_is_uniform(const Chunk *chunk, Block_Type *type);
+
+/* Returns true if every block on the given face of the chunk is opaque. */
+bool chunk_is_face_opaque(const Chunk *chunk, Direction face);
+
 #endif /* CHUNK_H */
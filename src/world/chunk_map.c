@@ -0,0 +1,203 @@
+#include "chunk_map.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MIN_CAPACITY 64
+
+/* The map grows once it is more than 1/2 full. Linear probing degrades quickly past that. */
+#define MAX_LOAD_NUMERATOR 1
+#define MAX_LOAD_DENOMINATOR 2
+
+/* log2(CHUNK_MAP_TILE_SIZE). A tile covers 1 << (3 * TILE_SHIFT) slots. */
+#define TILE_SHIFT 2
+#define TILE_MASK ((1u << TILE_SHIFT) - 1)
+
+static size_t hash_coord(iVec3 coord) {
+    /* Multiply each component by a large odd constant and mix the high bits back down, so
+     * neighboring chunks land far apart. */
+    uint64_t hash = (uint64_t)(uint32_t)coord.x * 0x9E3779B97F4A7C15ull;
+    hash ^= (uint64_t)(uint32_t)coord.y * 0xC2B2AE3D27D4EB4Full;
+    hash ^= (uint64_t)(uint32_t)coord.z * 0x165667B19E3779F9ull;
+    hash ^= hash >> 32;
+    return (size_t)hash;
+}
+
+/* Spreads the low TILE_SHIFT bits of `value` out to every third bit. */
+static size_t spread_tile_bits(uint32_t value) {
+    size_t spread = 0;
+    for (unsigned bit = 0; bit < TILE_SHIFT; bit++) {
+        spread |= (size_t)((value >> bit) & 1u) << (3 * bit);
+    }
+
+    return spread;
+}
+
+static size_t get_home_slot(Chunk_Map_Layout layout, iVec3 coord, size_t mask) {
+    if (layout == CHUNK_MAP_LAYOUT_HASHED) {
+        return hash_coord(coord) & mask;
+    }
+
+    /* Working on the unsigned bit patterns keeps tiles aligned across zero. */
+    uint32_t x = (uint32_t)coord.x;
+    uint32_t y = (uint32_t)coord.y;
+    uint32_t z = (uint32_t)coord.z;
+
+    iVec3 tile = {(int)(x >> TILE_SHIFT), (int)(y >> TILE_SHIFT), (int)(z >> TILE_SHIFT)};
+    size_t morton = spread_tile_bits(x & TILE_MASK) | spread_tile_bits(y & TILE_MASK) << 1 |
+                    spread_tile_bits(z & TILE_MASK) << 2;
+
+    return (hash_coord(tile) << (3 * TILE_SHIFT) | morton) & mask;
+}
+
+static bool coords_equal(iVec3 a, iVec3 b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static inline bool is_power_of_two(size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static Chunk_Map_Entry *allocate_entries(size_t capacity) {
+    Chunk_Map_Entry *entries = calloc(capacity, sizeof(Chunk_Map_Entry));
+    if (!entries) {
+        fprintf(stderr, "Chunk map is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return entries;
+}
+
+static void insert_entry(Chunk_Map_Entry *entries, size_t capacity, Chunk_Map_Layout layout,
+                         Chunk *chunk) {
+    size_t mask = capacity - 1;
+    size_t index = get_home_slot(layout, chunk->coord, mask);
+
+    while (entries[index].chunk) {
+        assert(!coords_equal(entries[index].coord, chunk->coord));
+        index = (index + 1) & mask;
+    }
+
+    entries[index] = (Chunk_Map_Entry){
+        .coord = chunk->coord,
+        .chunk = chunk,
+    };
+}
+
+static void rehash(Chunk_Map *map, size_t new_capacity, Chunk_Map_Layout new_layout) {
+    Chunk_Map_Entry *new_entries = allocate_entries(new_capacity);
+
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->entries[i].chunk) {
+            insert_entry(new_entries, new_capacity, new_layout, map->entries[i].chunk);
+        }
+    }
+
+    free(map->entries);
+    map->entries = new_entries;
+    map->capacity = new_capacity;
+    map->layout = new_layout;
+}
+
+bool chunk_map_create(Chunk_Map *map, size_t initial_capacity, Chunk_Map_Layout layout) {
+    assert(map != NULL);
+
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < initial_capacity) {
+        capacity *= 2;
+    }
+
+    *map = (Chunk_Map){
+        .entries = calloc(capacity, sizeof(Chunk_Map_Entry)),
+        .capacity = capacity,
+        .layout = layout,
+    };
+
+    return map->entries != NULL;
+}
+
+void chunk_map_destroy(Chunk_Map *map) {
+    assert(map != NULL);
+
+    free(map->entries);
+    *map = (Chunk_Map){0};
+}
+
+void chunk_map_set_layout(Chunk_Map *map, Chunk_Map_Layout layout) {
+    assert(map != NULL);
+
+    if (map->layout != layout) {
+        rehash(map, map->capacity, layout);
+    }
+}
+
+Chunk *chunk_map_get(const Chunk_Map *map, iVec3 coord) {
+    assert(map != NULL);
+    assert(is_power_of_two(map->capacity));
+
+    size_t mask = map->capacity - 1;
+    size_t index = get_home_slot(map->layout, coord, mask);
+
+    /* The map is never full, so there is always an empty slot to stop at. */
+    while (map->entries[index].chunk) {
+        if (coords_equal(map->entries[index].coord, coord)) {
+            return map->entries[index].chunk;
+        }
+
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+}
+
+void chunk_map_insert(Chunk_Map *map, Chunk *chunk) {
+    assert(map != NULL);
+    assert(chunk != NULL);
+
+    if ((map->count + 1) * MAX_LOAD_DENOMINATOR > map->capacity * MAX_LOAD_NUMERATOR) {
+        rehash(map, map->capacity * 2, map->layout);
+    }
+
+    insert_entry(map->entries, map->capacity, map->layout, chunk);
+    map->count++;
+}
+
+Chunk *chunk_map_remove(Chunk_Map *map, iVec3 coord) {
+    assert(map != NULL);
+
+    size_t mask = map->capacity - 1;
+    size_t index = get_home_slot(map->layout, coord, mask);
+
+    while (map->entries[index].chunk && !coords_equal(map->entries[index].coord, coord)) {
+        index = (index + 1) & mask;
+    }
+
+    Chunk *removed = map->entries[index].chunk;
+    if (!removed) {
+        return NULL;
+    }
+
+    /* Backward shift deletion: move later entries of the probe run into the hole if their home
+     * slot allows it, so lookups never need tombstones. */
+    size_t hole = index;
+    size_t next = (hole + 1) & mask;
+    while (map->entries[next].chunk) {
+        size_t home = get_home_slot(map->layout, map->entries[next].coord, mask);
+
+        /* The entry can move into the hole unless its home lies cyclically in (hole, next]. */
+        bool home_after_hole = ((next - home) & mask) < ((next - hole) & mask);
+        if (!home_after_hole) {
+            map->entries[hole] = map->entries[next];
+            hole = next;
+        }
+
+        next = (next + 1) & mask;
+    }
+
+    map->entries[hole] = (Chunk_Map_Entry){0};
+    map->count--;
+
+    return removed;
+}
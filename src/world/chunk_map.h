@@ -0,0 +1,58 @@
+#ifndef CHUNK_MAP_H
+#define CHUNK_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/math3d.h"
+#include "world/chunk.h"
+
+/* An open addressing hash map from chunk coordinates to chunks, using linear probing. The map
+ * doesn't own the chunks. */
+
+/* How coordinates are spread over the slots. */
+typedef enum Chunk_Map_Layout {
+    /* Every coordinate is hashed on its own, so neighboring chunks land far apart. */
+    CHUNK_MAP_LAYOUT_HASHED,
+
+    /* Coordinates are grouped into tiles of CHUNK_MAP_TILE_SIZE^3 chunks. Each tile is hashed to
+     * a run of slots, and its chunks are laid out in Morton (Z-order) within the run. A chunk's
+     * neighbors are then usually a few slots away, which keeps lookups of a neighborhood, and
+     * walks over the slots, on a handful of cache lines and pages. */
+    CHUNK_MAP_LAYOUT_MORTON,
+} Chunk_Map_Layout;
+
+#define CHUNK_MAP_TILE_SIZE 4
+
+typedef struct Chunk_Map_Entry {
+    iVec3 coord;
+
+    /* NULL if the slot is empty. */
+    Chunk *chunk;
+} Chunk_Map_Entry;
+
+typedef struct Chunk_Map {
+    /* Always a power of two, so the probe sequence can wrap with a mask. Iterate over all
+     * `capacity` entries and skip the empty ones to visit every chunk. */
+    Chunk_Map_Entry *entries;
+    size_t capacity;
+    size_t count;
+
+    Chunk_Map_Layout layout;
+} Chunk_Map;
+
+bool chunk_map_create(Chunk_Map *map, size_t initial_capacity, Chunk_Map_Layout layout);
+void chunk_map_destroy(Chunk_Map *map);
+
+Chunk *chunk_map_get(const Chunk_Map *map, iVec3 coord);
+
+/* Moves every entry to its slot in the new layout. */
+void chunk_map_set_layout(Chunk_Map *map, Chunk_Map_Layout layout);
+
+/* Inserts the chunk under its own coordinate, which must not already be in the map. */
+void chunk_map_insert(Chunk_Map *map, Chunk *chunk);
+
+/* Returns the removed chunk, or NULL if there was no chunk at the coordinate. */
+Chunk *chunk_map_remove(Chunk_Map *map, iVec3 coord);
+
+#endif /* CHUNK_MAP_H */
@@ -0,0 +1,372 @@
+#ifndef _WIN32
+/* For fileno(), fsync() and ftruncate(), which aren't part of C99. */
+#define _DEFAULT_SOURCE
+#endif
+
+#include "journal.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/timer.h"
+
+#ifdef _WIN32
+#include <io.h>
+
+static bool sync_file(FILE *file) {
+    return _commit(_fileno(file)) == 0;
+}
+
+static bool truncate_file(FILE *file, uint64_t size) {
+    return _chsize_s(_fileno(file), (__int64)size) == 0;
+}
+
+#else
+#include <unistd.h>
+
+static bool sync_file(FILE *file) {
+    return fsync(fileno(file)) == 0;
+}
+
+static bool truncate_file(FILE *file, uint64_t size) {
+    return ftruncate(fileno(file), (off_t)size) == 0;
+}
+
+#endif
+
+#define JOURNAL_MAGIC "QCJL"
+#define JOURNAL_VERSION 2
+#define JOURNAL_HEADER_SIZE 8
+#define JOURNAL_FILE_NAME "journal.qcj"
+
+#define FILL_RECORD_SIZE 26
+#define FEATURES_RECORD_SIZE 17
+#define MAX_RECORD_SIZE FILL_RECORD_SIZE
+
+#define MAX_PATH_LENGTH 512
+
+static void write_u32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+    out[2] = (uint8_t)((value >> 16) & 0xFF);
+    out[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+static uint32_t read_u32(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+static void write_ivec3(uint8_t *out, iVec3 value) {
+    write_u32(&out[0], (uint32_t)value.x);
+    write_u32(&out[4], (uint32_t)value.y);
+    write_u32(&out[8], (uint32_t)value.z);
+}
+
+static iVec3 read_ivec3(const uint8_t *in) {
+    return (iVec3){
+        .x = (int32_t)read_u32(&in[0]),
+        .y = (int32_t)read_u32(&in[4]),
+        .z = (int32_t)read_u32(&in[8]),
+    };
+}
+
+/* Returns the size of the record. */
+static size_t encode_edit(uint8_t *out, const Journal_Edit *edit) {
+    out[0] = (uint8_t)edit->kind;
+    write_ivec3(&out[1], edit->min);
+
+    switch (edit->kind) {
+    case JOURNAL_EDIT_BLOCK:
+        out[13] = edit->old_block;
+        out[14] = edit->new_block;
+        return JOURNAL_BLOCK_RECORD_SIZE;
+    case JOURNAL_EDIT_FILL:
+        write_ivec3(&out[13], edit->max);
+        out[25] = edit->new_block;
+        return FILL_RECORD_SIZE;
+    case JOURNAL_EDIT_FEATURES:
+        write_u32(&out[13], edit->feature_sources);
+        return FEATURES_RECORD_SIZE;
+    default:
+        assert(false && "Unknown journal edit kind");
+        return 0;
+    }
+}
+
+/* Returns the size of the record, or 0 if it is cut short or garbled. */
+static size_t decode_edit(const uint8_t *in, size_t size, Journal_Edit *edit) {
+    size_t record_size;
+    switch (size > 0 ? in[0] : 0) {
+    case JOURNAL_EDIT_BLOCK:
+        record_size = JOURNAL_BLOCK_RECORD_SIZE;
+        break;
+    case JOURNAL_EDIT_FILL:
+        record_size = FILL_RECORD_SIZE;
+        break;
+    case JOURNAL_EDIT_FEATURES:
+        record_size = FEATURES_RECORD_SIZE;
+        break;
+    default:
+        return 0;
+    }
+
+    if (size < record_size) {
+        return 0;
+    }
+
+    *edit = (Journal_Edit){
+        .kind = (Journal_Edit_Kind)in[0],
+        .min = read_ivec3(&in[1]),
+    };
+
+    if (edit->kind == JOURNAL_EDIT_BLOCK) {
+        edit->max = ivec3_add(edit->min, (iVec3){1, 1, 1});
+        edit->old_block = in[13];
+        edit->new_block = in[14];
+    } else if (edit->kind == JOURNAL_EDIT_FEATURES) {
+        edit->max = ivec3_add(edit->min, (iVec3){1, 1, 1});
+        edit->feature_sources = read_u32(&in[13]);
+    } else {
+        edit->max = read_ivec3(&in[13]);
+        edit->new_block = in[25];
+    }
+
+    return edit->old_block < BLOCK_TYPE_COUNT && edit->new_block < BLOCK_TYPE_COUNT
+               ? record_size
+               : 0;
+}
+
+static bool write_header(Edit_Journal *journal) {
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    memcpy(header, JOURNAL_MAGIC, 4);
+    write_u32(&header[4], JOURNAL_VERSION);
+
+    if (fseek(journal->file, 0, SEEK_SET) != 0 ||
+        fwrite(header, 1, sizeof(header), journal->file) != sizeof(header) ||
+        fflush(journal->file) != 0 || !sync_file(journal->file)) {
+        return false;
+    }
+
+    journal->file_size = JOURNAL_HEADER_SIZE;
+    return true;
+}
+
+bool edit_journal_remove(const char *directory) {
+    assert(directory != NULL);
+
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s", directory, JOURNAL_FILE_NAME);
+
+    return remove(path) == 0 || errno == ENOENT;
+}
+
+/* Checks the header, and finds the end of the file. */
+static bool read_header(Edit_Journal *journal) {
+    if (fseek(journal->file, 0, SEEK_END) != 0) {
+        return false;
+    }
+
+    long file_size = ftell(journal->file);
+    if (file_size < 0) {
+        return false;
+    }
+
+    /* The process died while the journal was being created. */
+    if (file_size < JOURNAL_HEADER_SIZE) {
+        return write_header(journal);
+    }
+
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    if (fseek(journal->file, 0, SEEK_SET) != 0 ||
+        fread(header, 1, sizeof(header), journal->file) != sizeof(header) ||
+        memcmp(header, JOURNAL_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    /* Edits from another version can't be replayed, but aren't thrown away either. */
+    uint32_t version = read_u32(&header[4]);
+    if (version != JOURNAL_VERSION) {
+        fprintf(stderr, "Journal has version %u, expected %u\n", version, JOURNAL_VERSION);
+        return false;
+    }
+
+    /* Cut short records at the end are found, and dropped, by edit_journal_read(). */
+    journal->file_size = (uint64_t)file_size;
+    return true;
+}
+
+bool edit_journal_open(Edit_Journal *journal, const char *directory) {
+    assert(journal != NULL);
+    assert(directory != NULL);
+
+    *journal = (Edit_Journal){0};
+
+    journal->pending = malloc(JOURNAL_PENDING_CAPACITY);
+    if (!journal->pending) {
+        fprintf(stderr, "Edit journal is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s", directory, JOURNAL_FILE_NAME);
+
+    journal->file = fopen(path, "r+b");
+    if (journal->file) {
+        if (!read_header(journal)) {
+            fprintf(stderr, "Journal %s is corrupt\n", path);
+            edit_journal_close(journal);
+            return false;
+        }
+
+        return true;
+    }
+
+    if (errno == ENOENT) {
+        journal->file = fopen(path, "w+b");
+    }
+
+    if (!journal->file || !write_header(journal)) {
+        fprintf(stderr, "Failed to create journal %s\n", path);
+        edit_journal_close(journal);
+        return false;
+    }
+
+    return true;
+}
+
+void edit_journal_close(Edit_Journal *journal) {
+    assert(journal != NULL);
+
+    if (journal->file) {
+        edit_journal_commit(journal);
+        fclose(journal->file);
+    }
+
+    free(journal->pending);
+
+    *journal = (Edit_Journal){0};
+}
+
+bool edit_journal_read(Edit_Journal *journal, Journal_Edit **edits, size_t *edit_count) {
+    assert(journal != NULL);
+    assert(edits != NULL);
+    assert(edit_count != NULL);
+
+    *edits = NULL;
+    *edit_count = 0;
+
+    size_t record_bytes = (size_t)(journal->file_size - JOURNAL_HEADER_SIZE);
+    if (record_bytes == 0) {
+        return true;
+    }
+
+    /* Every record is at least as large as a block record. */
+    size_t max_count = record_bytes / JOURNAL_BLOCK_RECORD_SIZE;
+    uint8_t *records = malloc(record_bytes);
+    *edits = malloc((max_count > 0 ? max_count : 1) * sizeof(Journal_Edit));
+    if (!records || !*edits) {
+        fprintf(stderr, "Edit journal is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (fseek(journal->file, JOURNAL_HEADER_SIZE, SEEK_SET) != 0 ||
+        fread(records, 1, record_bytes, journal->file) != record_bytes) {
+        fprintf(stderr, "Failed to read journal\n");
+        free(records);
+        free(*edits);
+        *edits = NULL;
+        return false;
+    }
+
+    /* A garbled record means the rest of the journal can't be trusted, and a record cut short
+     * was never committed. Later commits overwrite both. */
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset < record_bytes) {
+        size_t size = decode_edit(&records[offset], record_bytes - offset, &(*edits)[count]);
+        if (size == 0) {
+            break;
+        }
+
+        offset += size;
+        count++;
+    }
+
+    if (offset < record_bytes) {
+        fprintf(stderr, "Journal is corrupt after %zu edits, ignoring the rest\n", count);
+        journal->file_size = JOURNAL_HEADER_SIZE + offset;
+    }
+
+    free(records);
+    *edit_count = count;
+    return true;
+}
+
+void edit_journal_append(Edit_Journal *journal, const Journal_Edit *edit) {
+    assert(journal != NULL);
+    assert(edit != NULL);
+
+    /* If the commit fails, the edits are dropped from the journal to make room. They are still
+     * saved with their chunks. */
+    if (journal->pending_size + MAX_RECORD_SIZE > JOURNAL_PENDING_CAPACITY &&
+        !edit_journal_commit(journal)) {
+        journal->pending_size = 0;
+        journal->pending_count = 0;
+    }
+
+    if (journal->pending_count == 0) {
+        journal->first_pending_ns = get_time_ns();
+    }
+
+    journal->pending_size += encode_edit(&journal->pending[journal->pending_size], edit);
+    journal->pending_count++;
+}
+
+bool edit_journal_is_commit_due(const Edit_Journal *journal) {
+    assert(journal != NULL);
+
+    return journal->pending_count > 0 &&
+           get_time_ns() - journal->first_pending_ns >= JOURNAL_COMMIT_INTERVAL_NS;
+}
+
+bool edit_journal_commit(Edit_Journal *journal) {
+    assert(journal != NULL);
+
+    if (journal->pending_count == 0) {
+        return true;
+    }
+
+    size_t size = journal->pending_size;
+    if (fseek(journal->file, (long)journal->file_size, SEEK_SET) != 0 ||
+        fwrite(journal->pending, 1, size, journal->file) != size || fflush(journal->file) != 0 ||
+        !sync_file(journal->file)) {
+        fprintf(stderr, "Failed to commit %zu edits to the journal\n", journal->pending_count);
+        return false;
+    }
+
+    journal->file_size += size;
+    journal->committed_edit_count += journal->pending_count;
+    journal->commit_count++;
+    journal->pending_size = 0;
+    journal->pending_count = 0;
+    return true;
+}
+
+bool edit_journal_reset(Edit_Journal *journal) {
+    assert(journal != NULL);
+
+    journal->pending_size = 0;
+    journal->pending_count = 0;
+
+    if (fflush(journal->file) != 0 || !truncate_file(journal->file, JOURNAL_HEADER_SIZE) ||
+        !sync_file(journal->file)) {
+        fprintf(stderr, "Failed to reset journal\n");
+        return false;
+    }
+
+    journal->file_size = JOURNAL_HEADER_SIZE;
+    return true;
+}
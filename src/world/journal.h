@@ -0,0 +1,105 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "utils/math3d.h"
+#include "world/block_type.h"
+
+/* An append-only log of block edits, so edits that haven't reached the region files yet survive
+ * the process dying. All integers in the file are little endian.
+ *
+ *   magic "QCJL", u32 version
+ *   edit records, each starting with a u8 Journal_Edit_Kind:
+ *     JOURNAL_EDIT_BLOCK:    i32 x, i32 y, i32 z, u8 old type, u8 new type
+ *     JOURNAL_EDIT_FILL:     i32 min x, y, z, i32 max x, y, z, u8 new type
+ *     JOURNAL_EDIT_FEATURES: i32 x, i32 y, i32 z, u32 feature sources
+ *
+ * Replaying a record gives the same blocks whether or not the chunk was saved after it, so edits
+ * whose result depends on the blocks they find, such as replacements, are journaled as fills.
+ *
+ * A features record comes before the first edit of a chunk, and holds which chunks around it had
+ * placed their features in it, see Chunk.feature_sources. Its position is any block of the chunk.
+ * A chunk generated again to replay edits onto only gets those features.
+ *
+ * Edits are buffered and written in groups, so a burst of edits costs one fsync rather than one
+ * each. A record cut short by a crash is ignored, and overwritten by the next commit.
+ *
+ * Once every edited chunk is saved to the region files, the journal is reset to empty. */
+#define JOURNAL_BLOCK_RECORD_SIZE 15
+
+/* Pending edits are committed once the oldest has waited this long, or they fill the buffer. */
+#define JOURNAL_COMMIT_INTERVAL_NS 20000000ull
+#define JOURNAL_PENDING_CAPACITY (64 * 1024)
+
+typedef enum Journal_Edit_Kind {
+    JOURNAL_EDIT_BLOCK = 1,
+    JOURNAL_EDIT_FILL = 2,
+    JOURNAL_EDIT_FEATURES = 3,
+} Journal_Edit_Kind;
+
+typedef struct Journal_Edit {
+    Journal_Edit_Kind kind;
+
+    /* The edited box, from `min` (inclusive) to `max` (exclusive). A single block for
+     * JOURNAL_EDIT_BLOCK. */
+    iVec3 min;
+    iVec3 max;
+
+    /* The type that was there before. Only used by JOURNAL_EDIT_BLOCK. */
+    uint8_t old_block;
+    uint8_t new_block;
+
+    /* Only used by JOURNAL_EDIT_FEATURES. */
+    uint32_t feature_sources;
+} Journal_Edit;
+
+typedef struct Edit_Journal {
+    FILE *file;
+
+    /* Size of the file, including the header. New records are written here. */
+    uint64_t file_size;
+
+    /* Encoded edits waiting to be committed. */
+    uint8_t *pending;
+    size_t pending_size;
+    size_t pending_count;
+    uint64_t first_pending_ns;
+
+    /* Totals since the journal was opened, for statistics. */
+    uint64_t committed_edit_count;
+    uint64_t commit_count;
+} Edit_Journal;
+
+/* Opens the journal in `directory`, creating it if it doesn't exist. Edits already in it are kept
+ * for edit_journal_read(). */
+bool edit_journal_open(Edit_Journal *journal, const char *directory);
+
+/* Commits the pending edits and closes the file. */
+void edit_journal_close(Edit_Journal *journal);
+
+/* Reads every committed edit, oldest first, into a malloc'd array that the caller frees. Returns
+ * false if the file couldn't be read. */
+bool edit_journal_read(Edit_Journal *journal, Journal_Edit **edits, size_t *edit_count);
+
+/* Queues an edit, committing the queued edits first if there's no room for it. */
+void edit_journal_append(Edit_Journal *journal, const Journal_Edit *edit);
+
+/* True once the pending edits have waited long enough to be committed. */
+bool edit_journal_is_commit_due(const Edit_Journal *journal);
+
+/* Writes the pending edits and waits for them to reach the disk. */
+bool edit_journal_commit(Edit_Journal *journal);
+
+/* Drops every edit, committed or not. Only call this once the edits are safely in the region
+ * files. */
+bool edit_journal_reset(Edit_Journal *journal);
+
+/* Deletes the journal in `directory`, which must not be open. For throwaway worlds, such as the
+ * benchmark's. Returns true if there is no journal left, including if there never was one. */
+bool edit_journal_remove(const char *directory);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,685 @@
+#include "noise.h"
+
+#include <assert.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NOISE_HAS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define NOISE_HAS_X86 0
+#endif
+
+/* GCC and Clang only allow AVX2 intrinsics in functions compiled for it. MSVC allows them
+ * anywhere. */
+#if NOISE_HAS_X86 && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+/* Fusing a multiply and an add rounds once instead of twice, which would make the scalar kernel
+ * disagree with the others, and the terrain differ between machines. The core library is built
+ * with contraction turned off, see CMakeLists.txt, and Clang also honors the pragma. */
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+#define MAX_OCTAVE_COUNT 16
+
+/* Corner coordinates are multiplied by these and combined with the seed, then mixed. Since
+ * (x + 1) * PRIME_X = x * PRIME_X + PRIME_X, the far corners only cost an add. */
+#define PRIME_X 0x27D4EB2Du
+#define PRIME_Y 0x165667B1u
+#define PRIME_Z 0x9E3779B1u
+#define HASH_MULTIPLIER 0x2C1B3C6Du
+#define OCTAVE_SEED_STEP 0x85EBCA6Bu
+
+/* The 2D gradients have a length of sqrt(5), which would put the noise well outside -1 to 1. */
+#define NOISE_2D_SCALE 0.5f
+
+typedef struct Octave {
+    uint32_t seed;
+    float frequency;
+    float amplitude;
+} Octave;
+
+/* Resolves the per octave constants once, so every kernel uses exactly the same ones. Returns
+ * the factor the sum of the octaves is scaled by. */
+static float get_octaves(const Noise_Settings *settings, Octave *octaves) {
+    assert(settings->octave_count > 0 && settings->octave_count <= MAX_OCTAVE_COUNT);
+
+    uint32_t seed = settings->seed;
+    float frequency = settings->frequency;
+    float amplitude = 1.0f;
+    float total_amplitude = 0.0f;
+
+    for (int i = 0; i < settings->octave_count; i++) {
+        octaves[i] = (Octave){seed, frequency, amplitude};
+        total_amplitude += amplitude;
+
+        seed += OCTAVE_SEED_STEP;
+        frequency *= settings->lacunarity;
+        amplitude *= settings->gain;
+    }
+
+    return 1.0f / total_amplitude;
+}
+
+/* Scalar kernel. The other kernels mirror it operation for operation. */
+
+static uint32_t finish_hash(uint32_t hash) {
+    hash ^= hash >> 15;
+    hash *= HASH_MULTIPLIER;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/* Coordinates are truncated and then corrected, which is how the vector kernels floor. */
+static int32_t floor_to_int(float value) {
+    int32_t truncated = (int32_t)value;
+    return (float)truncated > value ? truncated - 1 : truncated;
+}
+
+static float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static float lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+/* One of (+-1, +-2) or (+-2, +-1). */
+static float gradient_2d(uint32_t hash, float x, float y) {
+    float u = (hash & 4) ? y : x;
+    float v = (hash & 4) ? x : y;
+    u = (hash & 1) ? -u : u;
+    v = (hash & 2) ? -v : v;
+    return u + (v + v);
+}
+
+/* One of the 12 edge directions of a cube, with 4 of them repeated to make 16. */
+static float gradient_3d(uint32_t hash, float x, float y, float z) {
+    hash &= 15;
+    float u = hash < 8 ? x : y;
+    float v = hash < 4 ? y : (hash == 12 || hash == 14 ? x : z);
+    u = (hash & 1) ? -u : u;
+    v = (hash & 2) ? -v : v;
+    return u + v;
+}
+
+static float noise_2d(uint32_t seed, float x, float y) {
+    int32_t cell_x = floor_to_int(x);
+    int32_t cell_y = floor_to_int(y);
+    float fx = x - (float)cell_x;
+    float fy = y - (float)cell_y;
+
+    uint32_t x0 = (uint32_t)cell_x * PRIME_X;
+    uint32_t y0 = (uint32_t)cell_y * PRIME_Y;
+    uint32_t x1 = x0 + PRIME_X;
+    uint32_t y1 = y0 + PRIME_Y;
+
+    float n00 = gradient_2d(finish_hash(seed ^ x0 ^ y0), fx, fy);
+    float n10 = gradient_2d(finish_hash(seed ^ x1 ^ y0), fx - 1.0f, fy);
+    float n01 = gradient_2d(finish_hash(seed ^ x0 ^ y1), fx, fy - 1.0f);
+    float n11 = gradient_2d(finish_hash(seed ^ x1 ^ y1), fx - 1.0f, fy - 1.0f);
+
+    float u = fade(fx);
+    float v = fade(fy);
+    return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v) * NOISE_2D_SCALE;
+}
+
+static float noise_3d(uint32_t seed, float x, float y, float z) {
+    int32_t cell_x = floor_to_int(x);
+    int32_t cell_y = floor_to_int(y);
+    int32_t cell_z = floor_to_int(z);
+    float fx = x - (float)cell_x;
+    float fy = y - (float)cell_y;
+    float fz = z - (float)cell_z;
+
+    uint32_t x0 = (uint32_t)cell_x * PRIME_X;
+    uint32_t y0 = (uint32_t)cell_y * PRIME_Y;
+    uint32_t z0 = (uint32_t)cell_z * PRIME_Z;
+    uint32_t x1 = x0 + PRIME_X;
+    uint32_t y1 = y0 + PRIME_Y;
+    uint32_t z1 = z0 + PRIME_Z;
+
+    float gx = fx - 1.0f;
+    float gy = fy - 1.0f;
+    float gz = fz - 1.0f;
+
+    float n000 = gradient_3d(finish_hash(seed ^ x0 ^ y0 ^ z0), fx, fy, fz);
+    float n100 = gradient_3d(finish_hash(seed ^ x1 ^ y0 ^ z0), gx, fy, fz);
+    float n010 = gradient_3d(finish_hash(seed ^ x0 ^ y1 ^ z0), fx, gy, fz);
+    float n110 = gradient_3d(finish_hash(seed ^ x1 ^ y1 ^ z0), gx, gy, fz);
+    float n001 = gradient_3d(finish_hash(seed ^ x0 ^ y0 ^ z1), fx, fy, gz);
+    float n101 = gradient_3d(finish_hash(seed ^ x1 ^ y0 ^ z1), gx, fy, gz);
+    float n011 = gradient_3d(finish_hash(seed ^ x0 ^ y1 ^ z1), fx, gy, gz);
+    float n111 = gradient_3d(finish_hash(seed ^ x1 ^ y1 ^ z1), gx, gy, gz);
+
+    float u = fade(fx);
+    float v = fade(fy);
+    float w = fade(fz);
+    float n00 = lerp(n000, n100, u);
+    float n10 = lerp(n010, n110, u);
+    float n01 = lerp(n001, n101, u);
+    float n11 = lerp(n011, n111, u);
+    return lerp(lerp(n00, n10, v), lerp(n01, n11, v), w);
+}
+
+static float fractal_2d_scalar(const Octave *octaves, int octave_count, float scale, float x,
+                               float y) {
+    float sum = 0.0f;
+    for (int i = 0; i < octave_count; i++) {
+        const Octave *octave = &octaves[i];
+        float value = noise_2d(octave->seed, x * octave->frequency, y * octave->frequency);
+        sum += octave->amplitude * value;
+    }
+
+    return sum * scale;
+}
+
+static float fractal_3d_scalar(const Octave *octaves, int octave_count, float scale, float x,
+                               float y, float z) {
+    float sum = 0.0f;
+    for (int i = 0; i < octave_count; i++) {
+        const Octave *octave = &octaves[i];
+        float value = noise_3d(octave->seed, x * octave->frequency, y * octave->frequency,
+                               z * octave->frequency);
+        sum += octave->amplitude * value;
+    }
+
+    return sum * scale;
+}
+
+#if NOISE_HAS_X86
+
+/* SSE2 kernel, 4 samples at a time. */
+
+/* SSE2 has no 32-bit multiply that keeps the low halves, so the even and odd lanes are multiplied
+ * into 64-bit products separately and their low halves interleaved back together. */
+static __m128i mullo_4(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static __m128i finish_hash_4(__m128i hash) {
+    hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 15));
+    hash = mullo_4(hash, _mm_set1_epi32((int)HASH_MULTIPLIER));
+    return _mm_xor_si128(hash, _mm_srli_epi32(hash, 13));
+}
+
+static __m128i xor3_4(__m128i a, __m128i b, __m128i c) {
+    return _mm_xor_si128(_mm_xor_si128(a, b), c);
+}
+
+/* All ones in the lanes where (hash & bits) == value. */
+static __m128 test_bits_4(__m128i hash, int bits, int value) {
+    __m128i masked = _mm_and_si128(hash, _mm_set1_epi32(bits));
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(masked, _mm_set1_epi32(value)));
+}
+
+static __m128 select_4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/* Negates the lanes of `value` where the mask is set. */
+static __m128 negate_4(__m128 mask, __m128 value) {
+    return _mm_xor_ps(value, _mm_and_ps(mask, _mm_set1_ps(-0.0f)));
+}
+
+static void floor_4(__m128 value, __m128i *cell, __m128 *fraction) {
+    __m128i truncated = _mm_cvttps_epi32(value);
+    __m128i is_above = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), value));
+
+    /* The comparison mask is -1 where the truncated value needs to be decremented. */
+    *cell = _mm_add_epi32(truncated, is_above);
+    *fraction = _mm_sub_ps(value, _mm_cvtepi32_ps(*cell));
+}
+
+static __m128 fade_4(__m128 t) {
+    __m128 polynomial = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f));
+    polynomial = _mm_add_ps(_mm_mul_ps(t, polynomial), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), polynomial);
+}
+
+static __m128 lerp_4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+static __m128 gradient_2d_4(__m128i hash, __m128 x, __m128 y) {
+    __m128 is_swapped = test_bits_4(hash, 4, 4);
+    __m128 u = negate_4(test_bits_4(hash, 1, 1), select_4(is_swapped, y, x));
+    __m128 v = negate_4(test_bits_4(hash, 2, 2), select_4(is_swapped, x, y));
+    return _mm_add_ps(u, _mm_add_ps(v, v));
+}
+
+static __m128 gradient_3d_4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+    __m128 u = select_4(test_bits_4(hash, 8, 0), x, y);
+    __m128 v = select_4(test_bits_4(hash, 12, 0), y, select_4(test_bits_4(hash, 13, 12), x, z));
+    u = negate_4(test_bits_4(hash, 1, 1), u);
+    v = negate_4(test_bits_4(hash, 2, 2), v);
+    return _mm_add_ps(u, v);
+}
+
+static __m128 noise_2d_4(__m128i seed, __m128 x, __m128 y) {
+    __m128i cell_x;
+    __m128i cell_y;
+    __m128 fx;
+    __m128 fy;
+    floor_4(x, &cell_x, &fx);
+    floor_4(y, &cell_y, &fy);
+
+    __m128i x0 = mullo_4(cell_x, _mm_set1_epi32((int)PRIME_X));
+    __m128i y0 = mullo_4(cell_y, _mm_set1_epi32((int)PRIME_Y));
+    __m128i x1 = _mm_add_epi32(x0, _mm_set1_epi32((int)PRIME_X));
+    __m128i y1 = _mm_add_epi32(y0, _mm_set1_epi32((int)PRIME_Y));
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 gx = _mm_sub_ps(fx, one);
+    __m128 gy = _mm_sub_ps(fy, one);
+
+    __m128 n00 = gradient_2d_4(finish_hash_4(xor3_4(seed, x0, y0)), fx, fy);
+    __m128 n10 = gradient_2d_4(finish_hash_4(xor3_4(seed, x1, y0)), gx, fy);
+    __m128 n01 = gradient_2d_4(finish_hash_4(xor3_4(seed, x0, y1)), fx, gy);
+    __m128 n11 = gradient_2d_4(finish_hash_4(xor3_4(seed, x1, y1)), gx, gy);
+
+    __m128 u = fade_4(fx);
+    __m128 v = fade_4(fy);
+    __m128 value = lerp_4(lerp_4(n00, n10, u), lerp_4(n01, n11, u), v);
+    return _mm_mul_ps(value, _mm_set1_ps(NOISE_2D_SCALE));
+}
+
+static __m128 noise_3d_4(__m128i seed, __m128 x, __m128 y, __m128 z) {
+    __m128i cell_x;
+    __m128i cell_y;
+    __m128i cell_z;
+    __m128 fx;
+    __m128 fy;
+    __m128 fz;
+    floor_4(x, &cell_x, &fx);
+    floor_4(y, &cell_y, &fy);
+    floor_4(z, &cell_z, &fz);
+
+    __m128i x0 = mullo_4(cell_x, _mm_set1_epi32((int)PRIME_X));
+    __m128i y0 = mullo_4(cell_y, _mm_set1_epi32((int)PRIME_Y));
+    __m128i z0 = mullo_4(cell_z, _mm_set1_epi32((int)PRIME_Z));
+    __m128i x1 = _mm_add_epi32(x0, _mm_set1_epi32((int)PRIME_X));
+    __m128i y1 = _mm_add_epi32(y0, _mm_set1_epi32((int)PRIME_Y));
+    __m128i z1 = _mm_add_epi32(z0, _mm_set1_epi32((int)PRIME_Z));
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 gx = _mm_sub_ps(fx, one);
+    __m128 gy = _mm_sub_ps(fy, one);
+    __m128 gz = _mm_sub_ps(fz, one);
+
+    /* The seed is folded into the z terms, leaving three xors per corner. */
+    __m128i sz0 = _mm_xor_si128(seed, z0);
+    __m128i sz1 = _mm_xor_si128(seed, z1);
+
+    __m128 n000 = gradient_3d_4(finish_hash_4(xor3_4(sz0, x0, y0)), fx, fy, fz);
+    __m128 n100 = gradient_3d_4(finish_hash_4(xor3_4(sz0, x1, y0)), gx, fy, fz);
+    __m128 n010 = gradient_3d_4(finish_hash_4(xor3_4(sz0, x0, y1)), fx, gy, fz);
+    __m128 n110 = gradient_3d_4(finish_hash_4(xor3_4(sz0, x1, y1)), gx, gy, fz);
+    __m128 n001 = gradient_3d_4(finish_hash_4(xor3_4(sz1, x0, y0)), fx, fy, gz);
+    __m128 n101 = gradient_3d_4(finish_hash_4(xor3_4(sz1, x1, y0)), gx, fy, gz);
+    __m128 n011 = gradient_3d_4(finish_hash_4(xor3_4(sz1, x0, y1)), fx, gy, gz);
+    __m128 n111 = gradient_3d_4(finish_hash_4(xor3_4(sz1, x1, y1)), gx, gy, gz);
+
+    __m128 u = fade_4(fx);
+    __m128 v = fade_4(fy);
+    __m128 w = fade_4(fz);
+    __m128 n00 = lerp_4(n000, n100, u);
+    __m128 n10 = lerp_4(n010, n110, u);
+    __m128 n01 = lerp_4(n001, n101, u);
+    __m128 n11 = lerp_4(n011, n111, u);
+    return lerp_4(lerp_4(n00, n10, v), lerp_4(n01, n11, v), w);
+}
+
+/* Returns the number of samples evaluated, a multiple of 4. */
+static size_t fractal_2d_sse2(const Octave *octaves, int octave_count, float scale,
+                              const float *x, const float *y, float *out, size_t count) {
+    size_t vector_count = count - count % 4;
+    for (size_t i = 0; i < vector_count; i += 4) {
+        __m128 sample_x = _mm_loadu_ps(&x[i]);
+        __m128 sample_y = _mm_loadu_ps(&y[i]);
+
+        __m128 sum = _mm_setzero_ps();
+        for (int j = 0; j < octave_count; j++) {
+            const Octave *octave = &octaves[j];
+            __m128 frequency = _mm_set1_ps(octave->frequency);
+            __m128 value = noise_2d_4(_mm_set1_epi32((int)octave->seed),
+                                      _mm_mul_ps(sample_x, frequency),
+                                      _mm_mul_ps(sample_y, frequency));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(octave->amplitude), value));
+        }
+
+        _mm_storeu_ps(&out[i], _mm_mul_ps(sum, _mm_set1_ps(scale)));
+    }
+
+    return vector_count;
+}
+
+static size_t fractal_3d_sse2(const Octave *octaves, int octave_count, float scale,
+                              const float *x, const float *y, const float *z, float *out,
+                              size_t count) {
+    size_t vector_count = count - count % 4;
+    for (size_t i = 0; i < vector_count; i += 4) {
+        __m128 sample_x = _mm_loadu_ps(&x[i]);
+        __m128 sample_y = _mm_loadu_ps(&y[i]);
+        __m128 sample_z = _mm_loadu_ps(&z[i]);
+
+        __m128 sum = _mm_setzero_ps();
+        for (int j = 0; j < octave_count; j++) {
+            const Octave *octave = &octaves[j];
+            __m128 frequency = _mm_set1_ps(octave->frequency);
+            __m128 value = noise_3d_4(
+                _mm_set1_epi32((int)octave->seed), _mm_mul_ps(sample_x, frequency),
+                _mm_mul_ps(sample_y, frequency), _mm_mul_ps(sample_z, frequency));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(octave->amplitude), value));
+        }
+
+        _mm_storeu_ps(&out[i], _mm_mul_ps(sum, _mm_set1_ps(scale)));
+    }
+
+    return vector_count;
+}
+
+/* AVX2 kernel, 8 samples at a time. */
+
+TARGET_AVX2 static __m256i finish_hash_8(__m256i hash) {
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32((int)HASH_MULTIPLIER));
+    return _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 13));
+}
+
+TARGET_AVX2 static __m256i xor3_8(__m256i a, __m256i b, __m256i c) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+}
+
+TARGET_AVX2 static __m256 test_bits_8(__m256i hash, int bits, int value) {
+    __m256i masked = _mm256_and_si256(hash, _mm256_set1_epi32(bits));
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(masked, _mm256_set1_epi32(value)));
+}
+
+TARGET_AVX2 static __m256 select_8(__m256 mask, __m256 a, __m256 b) {
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+TARGET_AVX2 static __m256 negate_8(__m256 mask, __m256 value) {
+    return _mm256_xor_ps(value, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f)));
+}
+
+TARGET_AVX2 static void floor_8(__m256 value, __m256i *cell, __m256 *fraction) {
+    __m256i truncated = _mm256_cvttps_epi32(value);
+    __m256 is_above = _mm256_cmp_ps(_mm256_cvtepi32_ps(truncated), value, _CMP_GT_OQ);
+
+    *cell = _mm256_add_epi32(truncated, _mm256_castps_si256(is_above));
+    *fraction = _mm256_sub_ps(value, _mm256_cvtepi32_ps(*cell));
+}
+
+TARGET_AVX2 static __m256 fade_8(__m256 t) {
+    __m256 polynomial = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)),
+                                      _mm256_set1_ps(15.0f));
+    polynomial = _mm256_add_ps(_mm256_mul_ps(t, polynomial), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), polynomial);
+}
+
+TARGET_AVX2 static __m256 lerp_8(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+TARGET_AVX2 static __m256 gradient_2d_8(__m256i hash, __m256 x, __m256 y) {
+    __m256 is_swapped = test_bits_8(hash, 4, 4);
+    __m256 u = negate_8(test_bits_8(hash, 1, 1), select_8(is_swapped, y, x));
+    __m256 v = negate_8(test_bits_8(hash, 2, 2), select_8(is_swapped, x, y));
+    return _mm256_add_ps(u, _mm256_add_ps(v, v));
+}
+
+TARGET_AVX2 static __m256 gradient_3d_8(__m256i hash, __m256 x, __m256 y, __m256 z) {
+    __m256 u = select_8(test_bits_8(hash, 8, 0), x, y);
+    __m256 v = select_8(test_bits_8(hash, 12, 0), y, select_8(test_bits_8(hash, 13, 12), x, z));
+    u = negate_8(test_bits_8(hash, 1, 1), u);
+    v = negate_8(test_bits_8(hash, 2, 2), v);
+    return _mm256_add_ps(u, v);
+}
+
+TARGET_AVX2 static __m256 noise_2d_8(__m256i seed, __m256 x, __m256 y) {
+    __m256i cell_x;
+    __m256i cell_y;
+    __m256 fx;
+    __m256 fy;
+    floor_8(x, &cell_x, &fx);
+    floor_8(y, &cell_y, &fy);
+
+    __m256i x0 = _mm256_mullo_epi32(cell_x, _mm256_set1_epi32((int)PRIME_X));
+    __m256i y0 = _mm256_mullo_epi32(cell_y, _mm256_set1_epi32((int)PRIME_Y));
+    __m256i x1 = _mm256_add_epi32(x0, _mm256_set1_epi32((int)PRIME_X));
+    __m256i y1 = _mm256_add_epi32(y0, _mm256_set1_epi32((int)PRIME_Y));
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 gx = _mm256_sub_ps(fx, one);
+    __m256 gy = _mm256_sub_ps(fy, one);
+
+    __m256 n00 = gradient_2d_8(finish_hash_8(xor3_8(seed, x0, y0)), fx, fy);
+    __m256 n10 = gradient_2d_8(finish_hash_8(xor3_8(seed, x1, y0)), gx, fy);
+    __m256 n01 = gradient_2d_8(finish_hash_8(xor3_8(seed, x0, y1)), fx, gy);
+    __m256 n11 = gradient_2d_8(finish_hash_8(xor3_8(seed, x1, y1)), gx, gy);
+
+    __m256 u = fade_8(fx);
+    __m256 v = fade_8(fy);
+    __m256 value = lerp_8(lerp_8(n00, n10, u), lerp_8(n01, n11, u), v);
+    return _mm256_mul_ps(value, _mm256_set1_ps(NOISE_2D_SCALE));
+}
+
+TARGET_AVX2 static __m256 noise_3d_8(__m256i seed, __m256 x, __m256 y, __m256 z) {
+    __m256i cell_x;
+    __m256i cell_y;
+    __m256i cell_z;
+    __m256 fx;
+    __m256 fy;
+    __m256 fz;
+    floor_8(x, &cell_x, &fx);
+    floor_8(y, &cell_y, &fy);
+    floor_8(z, &cell_z, &fz);
+
+    __m256i x0 = _mm256_mullo_epi32(cell_x, _mm256_set1_epi32((int)PRIME_X));
+    __m256i y0 = _mm256_mullo_epi32(cell_y, _mm256_set1_epi32((int)PRIME_Y));
+    __m256i z0 = _mm256_mullo_epi32(cell_z, _mm256_set1_epi32((int)PRIME_Z));
+    __m256i x1 = _mm256_add_epi32(x0, _mm256_set1_epi32((int)PRIME_X));
+    __m256i y1 = _mm256_add_epi32(y0, _mm256_set1_epi32((int)PRIME_Y));
+    __m256i z1 = _mm256_add_epi32(z0, _mm256_set1_epi32((int)PRIME_Z));
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 gx = _mm256_sub_ps(fx, one);
+    __m256 gy = _mm256_sub_ps(fy, one);
+    __m256 gz = _mm256_sub_ps(fz, one);
+
+    __m256i sz0 = _mm256_xor_si256(seed, z0);
+    __m256i sz1 = _mm256_xor_si256(seed, z1);
+
+    __m256 n000 = gradient_3d_8(finish_hash_8(xor3_8(sz0, x0, y0)), fx, fy, fz);
+    __m256 n100 = gradient_3d_8(finish_hash_8(xor3_8(sz0, x1, y0)), gx, fy, fz);
+    __m256 n010 = gradient_3d_8(finish_hash_8(xor3_8(sz0, x0, y1)), fx, gy, fz);
+    __m256 n110 = gradient_3d_8(finish_hash_8(xor3_8(sz0, x1, y1)), gx, gy, fz);
+    __m256 n001 = gradient_3d_8(finish_hash_8(xor3_8(sz1, x0, y0)), fx, fy, gz);
+    __m256 n101 = gradient_3d_8(finish_hash_8(xor3_8(sz1, x1, y0)), gx, fy, gz);
+    __m256 n011 = gradient_3d_8(finish_hash_8(xor3_8(sz1, x0, y1)), fx, gy, gz);
+    __m256 n111 = gradient_3d_8(finish_hash_8(xor3_8(sz1, x1, y1)), gx, gy, gz);
+
+    __m256 u = fade_8(fx);
+    __m256 v = fade_8(fy);
+    __m256 w = fade_8(fz);
+    __m256 n00 = lerp_8(n000, n100, u);
+    __m256 n10 = lerp_8(n010, n110, u);
+    __m256 n01 = lerp_8(n001, n101, u);
+    __m256 n11 = lerp_8(n011, n111, u);
+    return lerp_8(lerp_8(n00, n10, v), lerp_8(n01, n11, v), w);
+}
+
+TARGET_AVX2 static size_t fractal_2d_avx2(const Octave *octaves, int octave_count, float scale,
+                                          const float *x, const float *y, float *out,
+                                          size_t count) {
+    size_t vector_count = count - count % 8;
+    for (size_t i = 0; i < vector_count; i += 8) {
+        __m256 sample_x = _mm256_loadu_ps(&x[i]);
+        __m256 sample_y = _mm256_loadu_ps(&y[i]);
+
+        __m256 sum = _mm256_setzero_ps();
+        for (int j = 0; j < octave_count; j++) {
+            const Octave *octave = &octaves[j];
+            __m256 frequency = _mm256_set1_ps(octave->frequency);
+            __m256 value = noise_2d_8(_mm256_set1_epi32((int)octave->seed),
+                                      _mm256_mul_ps(sample_x, frequency),
+                                      _mm256_mul_ps(sample_y, frequency));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(octave->amplitude), value));
+        }
+
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(sum, _mm256_set1_ps(scale)));
+    }
+
+    return vector_count;
+}
+
+TARGET_AVX2 static size_t fractal_3d_avx2(const Octave *octaves, int octave_count, float scale,
+                                          const float *x, const float *y, const float *z,
+                                          float *out, size_t count) {
+    size_t vector_count = count - count % 8;
+    for (size_t i = 0; i < vector_count; i += 8) {
+        __m256 sample_x = _mm256_loadu_ps(&x[i]);
+        __m256 sample_y = _mm256_loadu_ps(&y[i]);
+        __m256 sample_z = _mm256_loadu_ps(&z[i]);
+
+        __m256 sum = _mm256_setzero_ps();
+        for (int j = 0; j < octave_count; j++) {
+            const Octave *octave = &octaves[j];
+            __m256 frequency = _mm256_set1_ps(octave->frequency);
+            __m256 value = noise_3d_8(
+                _mm256_set1_epi32((int)octave->seed), _mm256_mul_ps(sample_x, frequency),
+                _mm256_mul_ps(sample_y, frequency), _mm256_mul_ps(sample_z, frequency));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(octave->amplitude), value));
+        }
+
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(sum, _mm256_set1_ps(scale)));
+    }
+
+    return vector_count;
+}
+
+static bool cpu_has_avx2(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    /* The OS has to save the AVX registers on context switches, too. */
+    __cpuid(info, 1);
+    bool has_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+    if (!has_avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif /* NOISE_HAS_X86 */
+
+const char *noise_kernel_name(Noise_Kernel kernel) {
+    switch (kernel) {
+    case NOISE_KERNEL_SCALAR:
+        return "scalar";
+    case NOISE_KERNEL_SSE2:
+        return "sse2";
+    case NOISE_KERNEL_AVX2:
+        return "avx2";
+    default:
+        assert(false && "Unknown noise kernel");
+        return "unknown";
+    }
+}
+
+bool noise_is_kernel_supported(Noise_Kernel kernel) {
+    switch (kernel) {
+    case NOISE_KERNEL_SCALAR:
+        return true;
+#if NOISE_HAS_X86
+    case NOISE_KERNEL_SSE2:
+        return true;
+    case NOISE_KERNEL_AVX2:
+        return cpu_has_avx2();
+#endif
+    default:
+        return false;
+    }
+}
+
+Noise_Kernel noise_get_fastest_kernel(void) {
+    for (Noise_Kernel kernel = NOISE_KERNEL_COUNT - 1; kernel > NOISE_KERNEL_SCALAR; kernel--) {
+        if (noise_is_kernel_supported(kernel)) {
+            return kernel;
+        }
+    }
+
+    return NOISE_KERNEL_SCALAR;
+}
+
+void noise_fractal_2d(const Noise_Settings *settings, Noise_Kernel kernel, const float *x,
+                      const float *y, float *out, size_t count) {
+    assert(settings != NULL);
+    assert(noise_is_kernel_supported(kernel));
+
+    Octave octaves[MAX_OCTAVE_COUNT];
+    float scale = get_octaves(settings, octaves);
+    int octave_count = settings->octave_count;
+
+    /* The vector kernels leave the samples that don't fill a whole vector to the scalar one. */
+    size_t done = 0;
+#if NOISE_HAS_X86
+    if (kernel == NOISE_KERNEL_AVX2) {
+        done = fractal_2d_avx2(octaves, octave_count, scale, x, y, out, count);
+    } else if (kernel == NOISE_KERNEL_SSE2) {
+        done = fractal_2d_sse2(octaves, octave_count, scale, x, y, out, count);
+    }
+#else
+    (void)kernel;
+#endif
+
+    for (size_t i = done; i < count; i++) {
+        out[i] = fractal_2d_scalar(octaves, octave_count, scale, x[i], y[i]);
+    }
+}
+
+void noise_fractal_3d(const Noise_Settings *settings, Noise_Kernel kernel, const float *x,
+                      const float *y, const float *z, float *out, size_t count) {
+    assert(settings != NULL);
+    assert(noise_is_kernel_supported(kernel));
+
+    Octave octaves[MAX_OCTAVE_COUNT];
+    float scale = get_octaves(settings, octaves);
+    int octave_count = settings->octave_count;
+
+    size_t done = 0;
+#if NOISE_HAS_X86
+    if (kernel == NOISE_KERNEL_AVX2) {
+        done = fractal_3d_avx2(octaves, octave_count, scale, x, y, z, out, count);
+    } else if (kernel == NOISE_KERNEL_SSE2) {
+        done = fractal_3d_sse2(octaves, octave_count, scale, x, y, z, out, count);
+    }
+#else
+    (void)kernel;
+#endif
+
+    for (size_t i = done; i < count; i++) {
+        out[i] = fractal_3d_scalar(octaves, octave_count, scale, x[i], y[i], z[i]);
+    }
+}
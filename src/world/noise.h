@@ -0,0 +1,54 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Seeded gradient (Perlin) noise in 2D and 3D, summed over octaves of increasing frequency.
+ *
+ * Samples are evaluated in batches by one of several kernels. Every kernel performs the same
+ * float operations in the same order, so they all produce bit for bit the same output and the
+ * world looks the same whichever one the CPU supports. */
+
+typedef enum Noise_Kernel {
+    NOISE_KERNEL_SCALAR,
+
+    /* 4 samples per instruction. Always available on x86-64. */
+    NOISE_KERNEL_SSE2,
+
+    /* 8 samples per instruction. */
+    NOISE_KERNEL_AVX2,
+
+    NOISE_KERNEL_COUNT,
+} Noise_Kernel;
+
+typedef struct Noise_Settings {
+    uint32_t seed;
+
+    /* Octave i is sampled at frequency * lacunarity^i with weight gain^i. The sum is divided by
+     * the total weight, so it stays roughly within -1 to 1 whatever the octave count. */
+    int octave_count;
+    float frequency;
+    float lacunarity;
+    float gain;
+} Noise_Settings;
+
+const char *noise_kernel_name(Noise_Kernel kernel);
+
+/* Returns true if the kernel can run on this CPU. */
+bool noise_is_kernel_supported(Noise_Kernel kernel);
+
+/* The widest kernel the CPU supports. */
+Noise_Kernel noise_get_fastest_kernel(void);
+
+/* Writes the noise at (x[i], y[i]) to out[i] for `count` samples. The kernel must be
+ * supported. */
+void noise_fractal_2d(const Noise_Settings *settings, Noise_Kernel kernel, const float *x,
+                      const float *y, float *out, size_t count);
+
+/* Writes the noise at (x[i], y[i], z[i]) to out[i] for `count` samples. */
+void noise_fractal_3d(const Noise_Settings *settings, Noise_Kernel kernel, const float *x,
+                      const float *y, const float *z, float *out, size_t count);
+
+#endif /* NOISE_H */
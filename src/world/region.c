@@ -0,0 +1,759 @@
+#ifndef _WIN32
+/* For fileno() and fsync(), which aren't part of C99. */
+#define _DEFAULT_SOURCE
+#endif
+
+#include "region.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <direct.h>
+#include <io.h>
+
+static const uint8_t *map_file(FILE *file, size_t size) {
+    (void)size;
+
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        return NULL;
+    }
+
+    /* The view keeps the mapping alive. */
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    return view;
+}
+
+static void unmap_file(const uint8_t *view, size_t size) {
+    (void)size;
+    UnmapViewOfFile(view);
+}
+
+static bool make_directory(const char *path) {
+    return _mkdir(path) == 0 || errno == EEXIST;
+}
+
+static bool sync_file(FILE *file) {
+    return _commit(_fileno(file)) == 0;
+}
+
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+static const uint8_t *map_file(FILE *file, size_t size) {
+    void *view = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(file), 0);
+    if (view == MAP_FAILED) {
+        return NULL;
+    }
+
+    return view;
+}
+
+static void unmap_file(const uint8_t *view, size_t size) {
+    munmap((void *)view, size);
+}
+
+static bool make_directory(const char *path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+static bool sync_file(FILE *file) {
+    return fsync(fileno(file)) == 0;
+}
+
+#endif
+
+#define REGION_MAGIC "QCRG"
+#define REGION_VERSION 1
+#define REGION_HEADER_SIZE (8 + REGION_CHUNK_COUNT * 8)
+
+/* Chunk records start with a byte naming their encoding, and each chunk is saved with whichever
+ * encoding is smaller. Both cover the blocks in order of increasing x, then y, then z.
+ *
+ * RLE: a list of runs, each the block type followed by a u16 length. Best for layered terrain.
+ *
+ * Palette: the number of types, the types, then an index into them per block, packed LSB first
+ * into bytes at 1, 2, 4 or 8 bits. Best for mixed chunks, where runs are short. */
+#define RECORD_ENCODING_RLE 1
+#define RECORD_ENCODING_PALETTE 2
+#define RLE_RUN_SIZE 3
+#define MAX_RECORD_SIZE (2 + BLOCK_TYPE_COUNT + CHUNK_VOLUME)
+
+#define MAX_PATH_LENGTH 512
+
+static void write_u16(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+}
+
+static void write_u32(uint8_t *out, uint32_t value) {
+    write_u16(out, value & 0xFFFF);
+    write_u16(out + 2, value >> 16);
+}
+
+static uint32_t read_u16(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *in) {
+    return read_u16(in) | (read_u16(in + 2) << 16);
+}
+
+static size_t get_record_index(iVec3 chunk_coord) {
+    iVec3 local = ivec3_mod(chunk_coord, REGION_SIZE);
+    return (size_t)(local.x + REGION_SIZE * (local.y + REGION_SIZE * local.z));
+}
+
+static void get_region_path(const Region_Storage *storage, iVec3 region_coord, char *path) {
+    snprintf(path, MAX_PATH_LENGTH, "%s/r.%d.%d.%d.qcr", storage->directory, region_coord.x,
+             region_coord.y, region_coord.z);
+}
+
+static uint32_t get_palette_bits(uint32_t palette_size) {
+    if (palette_size <= 2) {
+        return 1;
+    } else if (palette_size <= 4) {
+        return 2;
+    } else if (palette_size <= 16) {
+        return 4;
+    }
+
+    return 8;
+}
+
+static uint32_t get_palette_record_size(uint32_t palette_size) {
+    return 2 + palette_size + CHUNK_VOLUME * get_palette_bits(palette_size) / 8;
+}
+
+/* Returns 0 if the record would be larger than max_size. */
+static uint32_t encode_rle_record(const uint8_t *blocks, uint8_t *out, uint32_t max_size) {
+    uint32_t size = 0;
+    out[size++] = RECORD_ENCODING_RLE;
+
+    size_t i = 0;
+    while (i < CHUNK_VOLUME) {
+        if (size + RLE_RUN_SIZE > max_size) {
+            return 0;
+        }
+
+        uint8_t type = blocks[i];
+
+        size_t run_length = 1;
+        while (i + run_length < CHUNK_VOLUME && blocks[i + run_length] == type) {
+            run_length++;
+        }
+
+        out[size] = type;
+        write_u16(&out[size + 1], (uint32_t)run_length);
+        size += RLE_RUN_SIZE;
+
+        i += run_length;
+    }
+
+    return size;
+}
+
+static uint32_t encode_palette_record(const Chunk *chunk, const uint8_t *blocks, uint8_t *out) {
+    uint8_t slots[BLOCK_TYPE_COUNT];
+    uint32_t palette_size = 0;
+
+    out[0] = RECORD_ENCODING_PALETTE;
+    for (uint32_t type = 0; type < BLOCK_TYPE_COUNT; type++) {
+        if (chunk->block_counts[type] > 0) {
+            slots[type] = (uint8_t)palette_size;
+            out[2 + palette_size++] = (uint8_t)type;
+        }
+    }
+    out[1] = (uint8_t)palette_size;
+
+    uint32_t bits = get_palette_bits(palette_size);
+    uint32_t blocks_per_byte = 8 / bits;
+    uint8_t *indices = &out[2 + palette_size];
+
+    for (size_t i = 0; i < CHUNK_VOLUME; i += blocks_per_byte) {
+        uint32_t packed = 0;
+        for (uint32_t j = 0; j < blocks_per_byte; j++) {
+            packed |= (uint32_t)slots[blocks[i + j]] << (j * bits);
+        }
+
+        *indices++ = (uint8_t)packed;
+    }
+
+    return get_palette_record_size(palette_size);
+}
+
+/* `blocks` is the chunk decoded in record order. */
+static uint32_t encode_record(const Chunk *chunk, const uint8_t *blocks, uint8_t *out) {
+    /* RLE is tried first, and gives up as soon as it can't beat the palette encoding. */
+    uint32_t palette_size = chunk->palette_type_count;
+    uint32_t size = encode_rle_record(blocks, out, get_palette_record_size(palette_size));
+    if (size != 0) {
+        return size;
+    }
+
+    return encode_palette_record(chunk, blocks, out);
+}
+
+static bool decode_rle_record(const uint8_t *record, uint32_t size, uint8_t *blocks) {
+    if ((size - 1) % RLE_RUN_SIZE != 0) {
+        return false;
+    }
+
+    size_t block_count = 0;
+    for (uint32_t offset = 1; offset < size; offset += RLE_RUN_SIZE) {
+        uint8_t type = record[offset];
+        size_t run_length = read_u16(&record[offset + 1]);
+
+        if (type >= BLOCK_TYPE_COUNT || run_length == 0 ||
+            run_length > CHUNK_VOLUME - block_count) {
+            return false;
+        }
+
+        memset(&blocks[block_count], type, run_length);
+        block_count += run_length;
+    }
+
+    return block_count == CHUNK_VOLUME;
+}
+
+static bool decode_palette_record(const uint8_t *record, uint32_t size, uint8_t *blocks) {
+    uint32_t palette_size = size >= 2 ? record[1] : 0;
+    if (palette_size == 0 || palette_size > BLOCK_TYPE_COUNT ||
+        size != get_palette_record_size(palette_size)) {
+        return false;
+    }
+
+    const uint8_t *palette = &record[2];
+    for (uint32_t i = 0; i < palette_size; i++) {
+        if (palette[i] >= BLOCK_TYPE_COUNT) {
+            return false;
+        }
+    }
+
+    uint32_t bits = get_palette_bits(palette_size);
+    uint32_t blocks_per_byte = 8 / bits;
+    uint32_t mask = (1u << bits) - 1;
+    const uint8_t *indices = &record[2 + palette_size];
+
+    for (size_t i = 0; i < CHUNK_VOLUME; i += blocks_per_byte) {
+        uint32_t packed = *indices++;
+
+        for (uint32_t j = 0; j < blocks_per_byte; j++) {
+            uint32_t slot = (packed >> (j * bits)) & mask;
+            if (slot >= palette_size) {
+                return false;
+            }
+
+            blocks[i + j] = palette[slot];
+        }
+    }
+
+    return true;
+}
+
+static bool decode_record(const uint8_t *record, uint32_t size, uint8_t *blocks) {
+    if (size < 1) {
+        return false;
+    }
+
+    switch (record[0]) {
+    case RECORD_ENCODING_RLE:
+        return decode_rle_record(record, size, blocks);
+    case RECORD_ENCODING_PALETTE:
+        return decode_palette_record(record, size, blocks);
+    default:
+        return false;
+    }
+}
+
+/* Table entries are only trusted if they point inside the file, past the header. */
+static bool is_record_in_file(const Region *region, Region_Record record) {
+    return record.size > 0 && record.size <= MAX_RECORD_SIZE &&
+           record.offset >= REGION_HEADER_SIZE && record.offset <= region->file_size &&
+           record.size <= region->file_size - record.offset;
+}
+
+static void unmap_region(Region *region) {
+    if (region->mapping) {
+        unmap_file(region->mapping, region->mapping_size);
+    }
+
+    region->mapping = NULL;
+    region->mapping_size = 0;
+}
+
+/* Maps the whole file as it is now. Records appended later are past the end of the mapping, and
+ * need the region to be mapped again. */
+static bool map_region(Region *region) {
+    unmap_region(region);
+
+    /* Saved records have to reach the file before they can be seen through the mapping. */
+    if (region->has_unflushed_writes) {
+        if (fflush(region->file) != 0) {
+            return false;
+        }
+        region->has_unflushed_writes = false;
+    }
+
+    region->mapping = map_file(region->file, region->file_size);
+    if (!region->mapping) {
+        return false;
+    }
+
+    region->mapping_size = region->file_size;
+    return true;
+}
+
+static void push_free_range(Region_Free_List *list, Region_Record range) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->ranges = realloc(list->ranges, sizeof(Region_Record) * list->capacity);
+        if (!list->ranges) {
+            fprintf(stderr, "Region storage is out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    list->ranges[list->count++] = range;
+}
+
+/* Returns the offset of unused space for a record of `size` bytes, which is the end of the file if
+ * no free range is large enough. */
+static uint32_t allocate_record_space(Region *region, uint32_t size) {
+    Region_Free_List *list = &region->free_space;
+
+    for (size_t i = 0; i < list->count; i++) {
+        Region_Record *range = &list->ranges[i];
+        if (range->size < size) {
+            continue;
+        }
+
+        uint32_t offset = range->offset;
+        range->offset += size;
+        range->size -= size;
+        if (range->size == 0) {
+            *range = list->ranges[--list->count];
+        }
+
+        return offset;
+    }
+
+    return region->file_size;
+}
+
+/* Writes the whole record table over the one in the file. */
+static bool write_record_table(Region *region) {
+    uint8_t *table = malloc(REGION_CHUNK_COUNT * 8);
+    if (!table) {
+        fprintf(stderr, "Region storage is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < REGION_CHUNK_COUNT; i++) {
+        write_u32(&table[i * 8], region->records[i].offset);
+        write_u32(&table[i * 8 + 4], region->records[i].size);
+    }
+
+    bool written = fseek(region->file, 8, SEEK_SET) == 0 &&
+                   fwrite(table, 1, REGION_CHUNK_COUNT * 8, region->file) == REGION_CHUNK_COUNT * 8;
+    free(table);
+    return written;
+}
+
+/* The records are synced before the table is written, since the disk may write the pages of a
+ * file in any order, and an entry that reached it before its record could point at the old
+ * contents of reused space. */
+static bool sync_region(Region *region) {
+    if (!region->file || !region->has_unsynced_writes) {
+        return true;
+    }
+
+    if (fflush(region->file) != 0 || !sync_file(region->file)) {
+        return false;
+    }
+
+    if (!write_record_table(region) || fflush(region->file) != 0 || !sync_file(region->file)) {
+        return false;
+    }
+
+    region->has_unflushed_writes = false;
+    region->has_unsynced_writes = false;
+
+    /* The table on the disk no longer points at the records that were moved. */
+    for (size_t i = 0; i < region->unsynced_free_space.count; i++) {
+        push_free_range(&region->free_space, region->unsynced_free_space.ranges[i]);
+    }
+    region->unsynced_free_space.count = 0;
+
+    return true;
+}
+
+/* Returns false if the region's writes couldn't be synced. It is closed either way. */
+static bool close_region(Region *region) {
+    unmap_region(region);
+
+    bool synced = true;
+    if (region->file) {
+        synced = sync_region(region);
+        fclose(region->file);
+    }
+
+    region->has_unflushed_writes = false;
+    region->has_unsynced_writes = false;
+    region->free_space.count = 0;
+    region->unsynced_free_space.count = 0;
+
+    region->file = NULL;
+    region->is_used = false;
+    return synced;
+}
+
+static int compare_record_offsets(const void *a, const void *b) {
+    uint32_t offset_a = ((const Region_Record *)a)->offset;
+    uint32_t offset_b = ((const Region_Record *)b)->offset;
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+/* Adds the space between the records in the table to the free space. */
+static void find_free_space(Region *region) {
+    Region_Record *records = malloc(sizeof(region->records));
+    if (!records) {
+        fprintf(stderr, "Region storage is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t record_count = 0;
+    for (size_t i = 0; i < REGION_CHUNK_COUNT; i++) {
+        if (is_record_in_file(region, region->records[i])) {
+            records[record_count++] = region->records[i];
+        }
+    }
+
+    qsort(records, record_count, sizeof(Region_Record), compare_record_offsets);
+
+    uint32_t used_end = REGION_HEADER_SIZE;
+    for (size_t i = 0; i <= record_count; i++) {
+        uint32_t next_offset = i < record_count ? records[i].offset : region->file_size;
+        if (next_offset > used_end) {
+            push_free_range(&region->free_space,
+                            (Region_Record){.offset = used_end, .size = next_offset - used_end});
+        }
+
+        if (i < record_count && records[i].offset + records[i].size > used_end) {
+            used_end = records[i].offset + records[i].size;
+        }
+    }
+
+    free(records);
+}
+
+/* Maps an existing region file and reads its record table. */
+static bool read_region_header(Region *region) {
+    if (fseek(region->file, 0, SEEK_END) != 0) {
+        return false;
+    }
+
+    long file_size = ftell(region->file);
+    if (file_size < REGION_HEADER_SIZE || (unsigned long)file_size > UINT32_MAX) {
+        return false;
+    }
+
+    region->file_size = (uint32_t)file_size;
+    if (!map_region(region)) {
+        return false;
+    }
+
+    const uint8_t *header = region->mapping;
+    if (memcmp(header, REGION_MAGIC, 4) != 0 || read_u32(&header[4]) != REGION_VERSION) {
+        return false;
+    }
+
+    for (size_t i = 0; i < REGION_CHUNK_COUNT; i++) {
+        region->records[i].offset = read_u32(&header[8 + i * 8]);
+        region->records[i].size = read_u32(&header[8 + i * 8 + 4]);
+    }
+
+    find_free_space(region);
+    return true;
+}
+
+/* Returns the region, opening its file if it isn't open yet. Regions without a file are returned
+ * with no records. Returns NULL if the file exists but can't be read. */
+static Region *get_region(Region_Storage *storage, iVec3 region_coord) {
+    Region *least_recently_used = &storage->regions[0];
+
+    for (size_t i = 0; i < MAX_OPEN_REGIONS; i++) {
+        Region *region = &storage->regions[i];
+
+        if (region->is_used && region->coord.x == region_coord.x &&
+            region->coord.y == region_coord.y && region->coord.z == region_coord.z) {
+            region->last_used = ++storage->use_counter;
+            return region;
+        }
+
+        if (!region->is_used) {
+            least_recently_used = region;
+        } else if (least_recently_used->is_used &&
+                   region->last_used < least_recently_used->last_used) {
+            least_recently_used = region;
+        }
+    }
+
+    Region *region = least_recently_used;
+    if (!close_region(region)) {
+        fprintf(stderr, "Failed to sync region (%d, %d, %d)\n", region->coord.x, region->coord.y,
+                region->coord.z);
+        storage->has_failed_sync = true;
+    }
+
+    region->coord = region_coord;
+    region->last_used = ++storage->use_counter;
+    region->file_size = 0;
+    memset(region->records, 0, sizeof(region->records));
+
+    char path[MAX_PATH_LENGTH];
+    get_region_path(storage, region_coord, path);
+
+    region->file = fopen(path, "r+b");
+    if (!region->file) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Failed to open region file %s\n", path);
+            return NULL;
+        }
+
+        region->is_used = true;
+        return region;
+    }
+
+    if (!read_region_header(region)) {
+        fprintf(stderr, "Region file %s is corrupt\n", path);
+        close_region(region);
+        return NULL;
+    }
+
+    region->is_used = true;
+    return region;
+}
+
+static bool create_region_file(Region_Storage *storage, Region *region) {
+    assert(region->file == NULL);
+
+    char path[MAX_PATH_LENGTH];
+    get_region_path(storage, region->coord, path);
+
+    region->file = fopen(path, "w+b");
+    if (!region->file) {
+        fprintf(stderr, "Failed to create region file %s\n", path);
+        return false;
+    }
+
+    /* Every record starts out empty. */
+    uint8_t *header = calloc(1, REGION_HEADER_SIZE);
+    if (!header) {
+        fprintf(stderr, "Region storage is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(header, REGION_MAGIC, 4);
+    write_u32(&header[4], REGION_VERSION);
+
+    bool written = fwrite(header, 1, REGION_HEADER_SIZE, region->file) == REGION_HEADER_SIZE;
+    free(header);
+
+    if (!written) {
+        fprintf(stderr, "Failed to write region file %s\n", path);
+        close_region(region);
+        return false;
+    }
+
+    region->file_size = REGION_HEADER_SIZE;
+    return true;
+}
+
+bool region_storage_create(Region_Storage *storage, const char *directory) {
+    assert(storage != NULL);
+    assert(directory != NULL);
+
+    *storage = (Region_Storage){
+        .directory = directory,
+    };
+
+    if (!make_directory(directory)) {
+        fprintf(stderr, "Failed to create world directory %s\n", directory);
+        return false;
+    }
+
+    storage->regions = calloc(MAX_OPEN_REGIONS, sizeof(Region));
+    storage->blocks = malloc(CHUNK_VOLUME);
+    storage->record = malloc(MAX_RECORD_SIZE);
+    if (!storage->regions || !storage->blocks || !storage->record) {
+        fprintf(stderr, "Region storage is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return true;
+}
+
+void region_storage_destroy(Region_Storage *storage) {
+    assert(storage != NULL);
+
+    for (size_t i = 0; i < MAX_OPEN_REGIONS; i++) {
+        close_region(&storage->regions[i]);
+        free(storage->regions[i].free_space.ranges);
+        free(storage->regions[i].unsynced_free_space.ranges);
+    }
+
+    free(storage->regions);
+    free(storage->blocks);
+    free(storage->record);
+
+    *storage = (Region_Storage){0};
+}
+
+bool region_storage_load_chunk(Region_Storage *storage, Chunk *chunk) {
+    assert(storage != NULL);
+    assert(chunk != NULL);
+
+    Region *region = get_region(storage, ivec3_floor_div(chunk->coord, REGION_SIZE));
+    if (!region || !region->file) {
+        return false;
+    }
+
+    Region_Record record = region->records[get_record_index(chunk->coord)];
+    if (record.size == 0) {
+        return false;
+    }
+
+    /* Records are decoded straight from the mapping, so reading them is left to the page cache,
+     * and only the pages of chunks that are actually loaded are ever touched. */
+    bool is_mapped = is_record_in_file(region, record);
+    if (is_mapped && (region->has_unflushed_writes ||
+                      record.offset + record.size > region->mapping_size)) {
+        is_mapped = map_region(region);
+    }
+
+    if (!is_mapped ||
+        !decode_record(&region->mapping[record.offset], record.size, storage->blocks)) {
+        fprintf(stderr, "Saved chunk (%d, %d, %d) is corrupt, regenerating it\n", chunk->coord.x,
+                chunk->coord.y, chunk->coord.z);
+        return false;
+    }
+
+    chunk_set_all_blocks_unsafe(chunk, storage->blocks);
+
+    storage->loaded_chunk_count++;
+    storage->loaded_bytes += record.size;
+    return true;
+}
+
+bool region_storage_save_chunk(Region_Storage *storage, const Chunk *chunk) {
+    assert(storage != NULL);
+    assert(chunk != NULL);
+
+    Region *region = get_region(storage, ivec3_floor_div(chunk->coord, REGION_SIZE));
+    if (!region) {
+        return false;
+    }
+
+    if (!region->file && !create_region_file(storage, region)) {
+        return false;
+    }
+
+    chunk_decode_unsafe(chunk, (iVec3){0, 0, 0}, (iVec3){CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE},
+                        storage->blocks, CHUNK_SIZE, CHUNK_SIZE * CHUNK_SIZE);
+    uint32_t size = encode_record(chunk, storage->blocks, storage->record);
+
+    /* The record always goes into unused space, and only the table in memory is pointed at it
+     * until the region is synced, so the table on the disk keeps pointing at the whole previous
+     * record. */
+    size_t index = get_record_index(chunk->coord);
+    Region_Record previous = region->records[index];
+    Region_Record record = {
+        .offset = allocate_record_space(region, size),
+        .size = size,
+    };
+
+    bool written = fseek(region->file, (long)record.offset, SEEK_SET) == 0 &&
+                   fwrite(storage->record, 1, size, region->file) == size;
+
+    if (!written) {
+        fprintf(stderr, "Failed to save chunk (%d, %d, %d)\n", chunk->coord.x, chunk->coord.y,
+                chunk->coord.z);
+        return false;
+    }
+
+    if (record.offset == region->file_size) {
+        region->file_size += size;
+    }
+    if (is_record_in_file(region, previous)) {
+        push_free_range(&region->unsynced_free_space, previous);
+    }
+    region->records[index] = record;
+    region->has_unflushed_writes = true;
+    region->has_unsynced_writes = true;
+
+    storage->saved_chunk_count++;
+    storage->saved_bytes += size;
+    return true;
+}
+
+bool region_storage_remove_region(Region_Storage *storage, iVec3 region_coord) {
+    assert(storage != NULL);
+
+    for (size_t i = 0; i < MAX_OPEN_REGIONS; i++) {
+        Region *region = &storage->regions[i];
+
+        if (region->is_used && region->coord.x == region_coord.x &&
+            region->coord.y == region_coord.y && region->coord.z == region_coord.z) {
+            close_region(region);
+        }
+    }
+
+    char path[MAX_PATH_LENGTH];
+    get_region_path(storage, region_coord, path);
+
+    return remove(path) == 0 || errno == ENOENT;
+}
+
+bool region_storage_flush(Region_Storage *storage) {
+    assert(storage != NULL);
+
+    bool flushed = true;
+    for (size_t i = 0; i < MAX_OPEN_REGIONS; i++) {
+        Region *region = &storage->regions[i];
+        if (!region->file) {
+            continue;
+        }
+
+        if (fflush(region->file) != 0) {
+            flushed = false;
+        } else {
+            region->has_unflushed_writes = false;
+        }
+    }
+
+    return flushed;
+}
+
+bool region_storage_sync(Region_Storage *storage) {
+    assert(storage != NULL);
+
+    bool synced = !storage->has_failed_sync;
+    for (size_t i = 0; i < MAX_OPEN_REGIONS; i++) {
+        if (!sync_region(&storage->regions[i])) {
+            synced = false;
+        }
+    }
+
+    return synced;
+}
@@ -0,0 +1,118 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "world/chunk.h"
+
+/* Chunks are saved in region files of REGION_SIZE^3 chunks each. A region file starts with a table
+ * of the offset and size of every chunk's record, so loading a chunk only reads its own record.
+ * All integers in the file are little endian.
+ *
+ *   magic "QCRG", u32 version
+ *   Region_Record records[REGION_CHUNK_COUNT], indexed by x + REGION_SIZE * (y + REGION_SIZE * z)
+ *   chunk records, in no particular order
+ *
+ * Records are never overwritten in place. A saved record is written to unused space, and the table
+ * on the disk is only pointed at it when the region is synced, after the record has reached the
+ * disk, so a crash before then leaves the previous record in use and intact. The space the
+ * previous record used is only reused once the new table has been synced.
+ *
+ * Region files are memory mapped read only, and chunk records are decoded straight out of the
+ * mapping, so loading leaves caching to the OS and opening a world doesn't read any chunks. Saves
+ * go through the file and are seen through the mapping once flushed. */
+#define REGION_SIZE 16
+#define REGION_CHUNK_COUNT (REGION_SIZE * REGION_SIZE * REGION_SIZE)
+
+/* Number of region files kept open at once. The least recently used one is closed first. */
+#define MAX_OPEN_REGIONS 16
+
+typedef struct Region_Record {
+    /* Both zero if the chunk was never saved. */
+    uint32_t offset;
+    uint32_t size;
+} Region_Record;
+
+/* Ranges of the file no table entry points at. */
+typedef struct Region_Free_List {
+    Region_Record *ranges;
+    size_t count;
+    size_t capacity;
+} Region_Free_List;
+
+typedef struct Region {
+    iVec3 coord;
+    bool is_used;
+    uint64_t last_used;
+
+    /* NULL until the first chunk of the region is saved, if the file doesn't exist yet. */
+    FILE *file;
+    uint32_t file_size;
+    bool has_unflushed_writes;
+
+    /* Set by saves until the file is synced to the disk, which is also when their table entries
+     * are written. Regions are synced when they are closed. */
+    bool has_unsynced_writes;
+
+    /* Space records were moved out of since the last sync is kept apart, since the table on the
+     * disk may still point at it. Gaps between records are found again when a file is opened. */
+    Region_Free_List free_space;
+    Region_Free_List unsynced_free_space;
+
+    /* The first `mapping_size` bytes of the file, or NULL if it isn't mapped. */
+    const uint8_t *mapping;
+    size_t mapping_size;
+
+    Region_Record records[REGION_CHUNK_COUNT];
+} Region;
+
+typedef struct Region_Storage {
+    const char *directory;
+
+    Region *regions;
+    uint64_t use_counter;
+
+    /* Set for good once a region closed to make room fails to sync. Records it wrote since its
+     * last sync may have no table entry, so region_storage_sync() fails from then on and the
+     * journal keeps every edit until the world is opened again. */
+    bool has_failed_sync;
+
+    /* Scratch space for a decoded chunk and for an encoded record to save. */
+    uint8_t *blocks;
+    uint8_t *record;
+
+    /* Totals since the storage was created, for statistics. */
+    size_t saved_chunk_count;
+    size_t loaded_chunk_count;
+    uint64_t saved_bytes;
+    uint64_t loaded_bytes;
+} Region_Storage;
+
+/* Region files are kept in `directory`, which is created if it doesn't exist. The string must
+ * outlive the storage. */
+bool region_storage_create(Region_Storage *storage, const char *directory);
+
+/* Flushes and closes every region file. */
+void region_storage_destroy(Region_Storage *storage);
+
+/* Fills a freshly initialized chunk from its saved record. Returns false if the chunk was never
+ * saved, or its record couldn't be read, in which case the chunk is left untouched. */
+bool region_storage_load_chunk(Region_Storage *storage, Chunk *chunk);
+
+bool region_storage_save_chunk(Region_Storage *storage, const Chunk *chunk);
+
+/* Closes the region's file and deletes it. For throwaway worlds, such as the benchmark's. Returns
+ * true if there is no file left, including if there never was one. */
+bool region_storage_remove_region(Region_Storage *storage, iVec3 region_coord);
+
+/* Writes out the records saved so far. Their table entries are only written by
+ * region_storage_sync(). */
+bool region_storage_flush(Region_Storage *storage);
+
+/* Writes out everything saved so far, table entries included, and waits for it to reach the
+ * disk. Always fails once a closed region has failed to sync. */
+bool region_storage_sync(Region_Storage *storage);
+
+#endif /* REGION_H */
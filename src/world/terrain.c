@@ -0,0 +1,448 @@
+#include "terrain.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+/* The surface rolls TERRAIN_HEIGHT_AMPLITUDE blocks above and below TERRAIN_BASE_HEIGHT at most,
+ * with hills a few hundred blocks across. */
+#define TERRAIN_BASE_HEIGHT 100
+#define TERRAIN_HEIGHT_AMPLITUDE 48.0f
+
+#define COLUMN_COUNT (CHUNK_SIZE * CHUNK_SIZE)
+
+/* Cave density is sampled every CAVE_CELL_SIZE blocks on each axis and interpolated in between.
+ * Caves are a few dozen blocks across, so the lattice is far finer than the noise. */
+#define CAVE_CELL_SIZE 4
+#define CAVE_CELLS_PER_CHUNK (CHUNK_SIZE / CAVE_CELL_SIZE)
+#define CAVE_LATTICE_SIZE (CAVE_CELLS_PER_CHUNK + 1)
+#define CAVE_LATTICE_VOLUME (CAVE_LATTICE_SIZE * CAVE_LATTICE_SIZE * CAVE_LATTICE_SIZE)
+
+/* Blocks whose density is above the threshold are carved out. Densities are fixed point, so the
+ * interpolation is exact and never leaves the range of the cell's corners: a cell whose corners
+ * are all on one side of the threshold is entirely on that side. */
+#define CAVE_DENSITY_SCALE 4096.0f
+#define CAVE_THRESHOLD ((int32_t)(0.3f * CAVE_DENSITY_SCALE))
+
+/* Interpolated densities are scaled by the product of the three weights, which add up to
+ * CAVE_CELL_SIZE each. */
+#define CAVE_WEIGHT_SCALE (CAVE_CELL_SIZE * CAVE_CELL_SIZE * CAVE_CELL_SIZE)
+
+/* One column of chunks in BOULDER_COLUMN_INTERVAL has a boulder sitting on its surface, placed by
+ * the chunk the surface passes through. Boulders reach at most BOULDER_MAX_RADIUS blocks past the
+ * chunk, into the chunks around it. Their centers are within the first BOULDER_CENTER_RANGE
+ * blocks of the chunk along x and z, so boulders of neighboring columns never overlap, and the
+ * order chunks are populated in doesn't matter. */
+#define BOULDER_COLUMN_INTERVAL 4
+#define BOULDER_MIN_RADIUS 2
+#define BOULDER_MAX_RADIUS 4
+#define BOULDER_CENTER_RANGE (CHUNK_SIZE - 2 * BOULDER_MAX_RADIUS - 1)
+
+static struct {
+    Noise_Settings height_noise;
+    Noise_Settings cave_noise;
+    bool has_caves;
+    Noise_Kernel kernel;
+} terrain = {
+    .height_noise =
+        {
+            .seed = TERRAIN_DEFAULT_SEED,
+            .octave_count = 5,
+            .frequency = 1.0f / 256.0f,
+            .lacunarity = 2.0f,
+            .gain = 0.5f,
+        },
+    .cave_noise =
+        {
+            .seed = TERRAIN_DEFAULT_SEED ^ TERRAIN_CAVE_SEED_SALT,
+            .octave_count = 2,
+            .frequency = 1.0f / 64.0f,
+            .lacunarity = 2.0f,
+            .gain = 0.5f,
+        },
+    .has_caves = true,
+    .kernel = NOISE_KERNEL_SCALAR,
+};
+
+void terrain_init(uint32_t seed, Noise_Kernel kernel, bool has_caves) {
+    assert(noise_is_kernel_supported(kernel));
+
+    terrain.height_noise.seed = seed;
+    terrain.cave_noise.seed = seed ^ TERRAIN_CAVE_SEED_SALT;
+    terrain.has_caves = has_caves;
+    terrain.kernel = kernel;
+}
+
+static int get_height_from_noise(float noise) {
+    return TERRAIN_BASE_HEIGHT + (int)floorf(noise * TERRAIN_HEIGHT_AMPLITUDE);
+}
+
+int terrain_get_height(int x, int z) {
+    float sample_x = (float)x;
+    float sample_z = (float)z;
+    float noise;
+    noise_fractal_2d(&terrain.height_noise, terrain.kernel, &sample_x, &sample_z, &noise, 1);
+
+    return get_height_from_noise(noise);
+}
+
+/* Samples the density at `count` lattice points, given in lattice units. */
+static void sample_cave_densities(const iVec3 *points, int32_t *densities, size_t count) {
+    assert(count <= CAVE_LATTICE_VOLUME);
+
+    float sample_x[CAVE_LATTICE_VOLUME];
+    float sample_y[CAVE_LATTICE_VOLUME];
+    float sample_z[CAVE_LATTICE_VOLUME];
+    float noise[CAVE_LATTICE_VOLUME];
+    for (size_t i = 0; i < count; i++) {
+        sample_x[i] = (float)(points[i].x * CAVE_CELL_SIZE);
+        sample_y[i] = (float)(points[i].y * CAVE_CELL_SIZE);
+        sample_z[i] = (float)(points[i].z * CAVE_CELL_SIZE);
+    }
+
+    noise_fractal_3d(&terrain.cave_noise, terrain.kernel, sample_x, sample_y, sample_z, noise,
+                     count);
+
+    for (size_t i = 0; i < count; i++) {
+        densities[i] = (int32_t)floorf(noise[i] * CAVE_DENSITY_SCALE);
+    }
+}
+
+/* The density at `offset` blocks from the cell's first corner, times CAVE_WEIGHT_SCALE. The
+ * corners are in order of increasing x, then y, then z. */
+static int32_t interpolate_cave_density(const int32_t *corners, iVec3 offset) {
+    int32_t weights_x[2] = {CAVE_CELL_SIZE - offset.x, offset.x};
+    int32_t weights_y[2] = {CAVE_CELL_SIZE - offset.y, offset.y};
+    int32_t weights_z[2] = {CAVE_CELL_SIZE - offset.z, offset.z};
+
+    int32_t density = 0;
+    for (int i = 0; i < 8; i++) {
+        density += corners[i] * weights_x[i & 1] * weights_y[(i >> 1) & 1] * weights_z[i >> 2];
+    }
+
+    return density;
+}
+
+Block_Type generate_block(iVec3 position) {
+    int height = terrain_get_height(position.x, position.z);
+
+    if (position.y > height) {
+        return BLOCK_AIR;
+    }
+
+    if (terrain.has_caves) {
+        iVec3 cell = ivec3_floor_div(position, CAVE_CELL_SIZE);
+
+        iVec3 corner_points[8];
+        for (int i = 0; i < 8; i++) {
+            corner_points[i] = ivec3_add(cell, (iVec3){i & 1, (i >> 1) & 1, i >> 2});
+        }
+
+        int32_t corners[8];
+        sample_cave_densities(corner_points, corners, 8);
+
+        iVec3 offset = ivec3_sub(position, ivec3_scale(cell, CAVE_CELL_SIZE));
+        if (interpolate_cave_density(corners, offset) > CAVE_THRESHOLD * CAVE_WEIGHT_SCALE) {
+            return BLOCK_AIR;
+        }
+    }
+
+    return position.y < height ? BLOCK_DIRT : BLOCK_GRASS;
+}
+
+typedef enum Chunk_Extent {
+    CHUNK_EXTENT_ABOVE_SURFACE,
+    CHUNK_EXTENT_BELOW_SURFACE,
+    CHUNK_EXTENT_SURFACE,
+} Chunk_Extent;
+
+/* Writes the height of the grass surface of each of the chunk's columns, relative to the bottom of
+ * the chunk, in order of increasing x, then z, and returns where the chunk lies relative to it. */
+static Chunk_Extent sample_heights(iVec3 chunk_coord, int *heights) {
+    iVec3 world_offset = ivec3_scale(chunk_coord, CHUNK_SIZE);
+
+    /* The whole heightmap of the chunk is sampled in one batch, so the noise kernel runs on full
+     * vectors. */
+    float sample_x[COLUMN_COUNT];
+    float sample_z[COLUMN_COUNT];
+    float noise[COLUMN_COUNT];
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            sample_x[x + z * CHUNK_SIZE] = (float)(world_offset.x + x);
+            sample_z[x + z * CHUNK_SIZE] = (float)(world_offset.z + z);
+        }
+    }
+
+    noise_fractal_2d(&terrain.height_noise, terrain.kernel, sample_x, sample_z, noise,
+                     COLUMN_COUNT);
+
+    int min_height = INT_MAX;
+    int max_height = INT_MIN;
+    for (int i = 0; i < COLUMN_COUNT; i++) {
+        heights[i] = get_height_from_noise(noise[i]) - world_offset.y;
+        min_height = heights[i] < min_height ? heights[i] : min_height;
+        max_height = heights[i] > max_height ? heights[i] : max_height;
+    }
+
+    if (max_height < 0) {
+        return CHUNK_EXTENT_ABOVE_SURFACE;
+    }
+
+    return min_height >= CHUNK_SIZE ? CHUNK_EXTENT_BELOW_SURFACE : CHUNK_EXTENT_SURFACE;
+}
+
+/* Samples the cave density at every lattice point of the chunk, in order of increasing x, then y,
+ * then z. All of them are sampled in one batch. */
+static void sample_cave_lattice(iVec3 chunk_coord, int32_t *densities) {
+    iVec3 first_point = ivec3_scale(chunk_coord, CAVE_CELLS_PER_CHUNK);
+
+    iVec3 points[CAVE_LATTICE_VOLUME];
+    size_t i = 0;
+    for (int z = 0; z < CAVE_LATTICE_SIZE; z++) {
+        for (int y = 0; y < CAVE_LATTICE_SIZE; y++) {
+            for (int x = 0; x < CAVE_LATTICE_SIZE; x++) {
+                points[i++] = ivec3_add(first_point, (iVec3){x, y, z});
+            }
+        }
+    }
+
+    sample_cave_densities(points, densities, CAVE_LATTICE_VOLUME);
+}
+
+static void get_cell_corners(const int32_t *densities, iVec3 cell, int32_t *corners) {
+    for (int i = 0; i < 8; i++) {
+        int x = cell.x + (i & 1);
+        int y = cell.y + ((i >> 1) & 1);
+        int z = cell.z + (i >> 2);
+        corners[i] = densities[x + CAVE_LATTICE_SIZE * (y + CAVE_LATTICE_SIZE * z)];
+    }
+}
+
+/* Carves the caves out of the blocks, and returns the number of blocks carved. Cells entirely
+ * outside the caves are skipped and cells entirely inside them are cleared in rows, so only cells
+ * the edge of a cave passes through are interpolated block by block. */
+static size_t carve_caves(iVec3 chunk_coord, uint8_t *blocks) {
+    int32_t densities[CAVE_LATTICE_VOLUME];
+    sample_cave_lattice(chunk_coord, densities);
+
+    size_t carved_count = 0;
+    for (int cell_z = 0; cell_z < CAVE_CELLS_PER_CHUNK; cell_z++) {
+        for (int cell_y = 0; cell_y < CAVE_CELLS_PER_CHUNK; cell_y++) {
+            for (int cell_x = 0; cell_x < CAVE_CELLS_PER_CHUNK; cell_x++) {
+                iVec3 cell = {cell_x, cell_y, cell_z};
+                int32_t corners[8];
+                get_cell_corners(densities, cell, corners);
+
+                int32_t min_density = corners[0];
+                int32_t max_density = corners[0];
+                for (int i = 1; i < 8; i++) {
+                    min_density = corners[i] < min_density ? corners[i] : min_density;
+                    max_density = corners[i] > max_density ? corners[i] : max_density;
+                }
+
+                if (max_density <= CAVE_THRESHOLD) {
+                    continue;
+                }
+
+                iVec3 cell_min = ivec3_scale(cell, CAVE_CELL_SIZE);
+                bool is_cave = min_density > CAVE_THRESHOLD;
+
+                for (int z = 0; z < CAVE_CELL_SIZE; z++) {
+                    for (int y = 0; y < CAVE_CELL_SIZE; y++) {
+                        size_t row_index =
+                            (size_t)(cell_min.x +
+                                     CHUNK_SIZE * (cell_min.y + y + CHUNK_SIZE * (cell_min.z + z)));
+                        uint8_t *row = &blocks[row_index];
+
+                        if (is_cave) {
+                            memset(row, BLOCK_AIR, CAVE_CELL_SIZE);
+                            carved_count += CAVE_CELL_SIZE;
+                            continue;
+                        }
+
+                        for (int x = 0; x < CAVE_CELL_SIZE; x++) {
+                            int32_t density = interpolate_cave_density(corners, (iVec3){x, y, z});
+                            if (density > CAVE_THRESHOLD * CAVE_WEIGHT_SCALE) {
+                                row[x] = BLOCK_AIR;
+                                carved_count++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return carved_count;
+}
+
+static int clamp_int(int value, int min, int max) {
+    return value < min ? min : value > max ? max : value;
+}
+
+/* Each column is dirt up to its surface, grass at the surface, and air above. The rows of a slice
+ * are contiguous, so the rows below every surface in the slice are one run of dirt and the rows
+ * above every surface are one run of air. Only the band of rows in between is written column by
+ * column, a layer at a time. */
+static void fill_column_spans(const int *heights, uint8_t *blocks) {
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        const int *slice_heights = &heights[z * CHUNK_SIZE];
+        uint8_t *slice = &blocks[CHUNK_SIZE * CHUNK_SIZE * z];
+
+        int min_height = INT_MAX;
+        int max_height = INT_MIN;
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            min_height = slice_heights[x] < min_height ? slice_heights[x] : min_height;
+            max_height = slice_heights[x] > max_height ? slice_heights[x] : max_height;
+        }
+
+        /* The band is from band_min up to, but not including, band_max. */
+        int band_min = clamp_int(min_height, 0, CHUNK_SIZE);
+        int band_max = clamp_int(max_height + 1, band_min, CHUNK_SIZE);
+
+        memset(slice, BLOCK_DIRT, (size_t)(band_min * CHUNK_SIZE));
+        memset(&slice[band_max * CHUNK_SIZE], BLOCK_AIR,
+               (size_t)((CHUNK_SIZE - band_max) * CHUNK_SIZE));
+
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int height = slice_heights[x];
+            int dirt_max = clamp_int(height, band_min, band_max);
+
+            int y = band_min;
+            for (; y < dirt_max; y++) {
+                slice[x + y * CHUNK_SIZE] = BLOCK_DIRT;
+            }
+
+            if (y == height && y < band_max) {
+                slice[x + y * CHUNK_SIZE] = BLOCK_GRASS;
+                y++;
+            }
+
+            for (; y < band_max; y++) {
+                slice[x + y * CHUNK_SIZE] = BLOCK_AIR;
+            }
+        }
+    }
+}
+
+/* A small integer hash, so features are placed the same on every platform. */
+static uint32_t hash_u32(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+    return value;
+}
+
+static bool is_in_boulder(iVec3 offset, int radius) {
+    return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= radius * (radius + 1);
+}
+
+void populate_chunk(iVec3 chunk_coord, Population_Queue *queue) {
+    uint32_t hash = hash_u32(terrain.height_noise.seed ^
+                             hash_u32(hash_u32((uint32_t)chunk_coord.x) ^ (uint32_t)chunk_coord.z));
+    if (hash % BOULDER_COLUMN_INTERVAL != 0) {
+        return;
+    }
+
+    iVec3 origin = ivec3_scale(chunk_coord, CHUNK_SIZE);
+    int x = origin.x + (int)((hash >> 8) % BOULDER_CENTER_RANGE);
+    int z = origin.z + (int)((hash >> 16) % BOULDER_CENTER_RANGE);
+    int height = terrain_get_height(x, z);
+    if (height < origin.y || height >= origin.y + CHUNK_SIZE) {
+        return;
+    }
+
+    /* Half sunk into the ground. Only the air around it is filled, so the terrain stays as it
+     * is, and the blocks at the top of the boulder are grass. */
+    int radius_range = BOULDER_MAX_RADIUS - BOULDER_MIN_RADIUS + 1;
+    int radius = BOULDER_MIN_RADIUS + (int)((hash >> 24) % (uint32_t)radius_range);
+    iVec3 center = {x, height + radius / 2, z};
+
+    for (int dz = -radius; dz <= radius; dz++) {
+        for (int dy = -radius; dy <= radius; dy++) {
+            for (int dx = -radius; dx <= radius; dx++) {
+                if (!is_in_boulder((iVec3){dx, dy, dz}, radius)) {
+                    continue;
+                }
+
+                bool is_top = !is_in_boulder((iVec3){dx, dy + 1, dz}, radius);
+                population_queue_push(queue, ivec3_add(center, (iVec3){dx, dy, dz}),
+                                      is_top ? BLOCK_GRASS : BLOCK_DIRT);
+            }
+        }
+    }
+}
+
+void generate_chunk(Chunk *chunk, iVec3 chunk_coord) {
+    int heights[COLUMN_COUNT];
+    Chunk_Extent extent = sample_heights(chunk_coord, heights);
+
+    if (extent == CHUNK_EXTENT_ABOVE_SURFACE) {
+        return;
+    }
+
+    iVec3 chunk_max = {CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+    if (extent == CHUNK_EXTENT_BELOW_SURFACE && !terrain.has_caves) {
+        chunk_fill_box_unsafe(chunk, (iVec3){0, 0, 0}, chunk_max, BLOCK_DIRT);
+        return;
+    }
+
+    uint8_t blocks[CHUNK_VOLUME];
+    if (extent == CHUNK_EXTENT_BELOW_SURFACE) {
+        memset(blocks, BLOCK_DIRT, sizeof(blocks));
+    } else {
+        fill_column_spans(heights, blocks);
+    }
+
+    size_t carved_count = terrain.has_caves ? carve_caves(chunk_coord, blocks) : 0;
+
+    /* Solid chunks without caves don't need their blocks packed. */
+    if (extent == CHUNK_EXTENT_BELOW_SURFACE && carved_count == 0) {
+        chunk_fill_box_unsafe(chunk, (iVec3){0, 0, 0}, chunk_max, BLOCK_DIRT);
+        return;
+    }
+
+    chunk_set_all_blocks_unsafe(chunk, blocks);
+}
+
+void generate_chunk_per_voxel(Chunk *chunk, iVec3 chunk_coord) {
+    int heights[COLUMN_COUNT];
+    if (sample_heights(chunk_coord, heights) == CHUNK_EXTENT_ABOVE_SURFACE) {
+        return;
+    }
+
+    int32_t densities[CAVE_LATTICE_VOLUME];
+    if (terrain.has_caves) {
+        sample_cave_lattice(chunk_coord, densities);
+    }
+
+    uint8_t blocks[CHUNK_VOLUME];
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            uint8_t *row = &blocks[CHUNK_SIZE * (y + CHUNK_SIZE * z)];
+            const int *row_heights = &heights[z * CHUNK_SIZE];
+
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                int height = row_heights[x];
+                row[x] = (uint8_t)(y < height ? BLOCK_DIRT : y == height ? BLOCK_GRASS : BLOCK_AIR);
+
+                if (terrain.has_caves && row[x] != BLOCK_AIR) {
+                    iVec3 cell = {x / CAVE_CELL_SIZE, y / CAVE_CELL_SIZE, z / CAVE_CELL_SIZE};
+                    iVec3 offset = {x % CAVE_CELL_SIZE, y % CAVE_CELL_SIZE, z % CAVE_CELL_SIZE};
+
+                    int32_t corners[8];
+                    get_cell_corners(densities, cell, corners);
+                    if (interpolate_cave_density(corners, offset) >
+                        CAVE_THRESHOLD * CAVE_WEIGHT_SCALE) {
+                        row[x] = BLOCK_AIR;
+                    }
+                }
+            }
+        }
+    }
+
+    chunk_set_all_blocks_unsafe(chunk, blocks);
+}
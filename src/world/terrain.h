@@ -0,0 +1,43 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils/math3d.h"
+#include "world/block_type.h"
+#include "world/chunk.h"
+#include "world/noise.h"
+#include "world/world.h"
+
+#define TERRAIN_DEFAULT_SEED 1337u
+
+/* Mixed into the seed of the cave noise, so caves don't follow the hills. */
+#define TERRAIN_CAVE_SEED_SALT 0x9E3779B9u
+
+/* Sets the seed of the generated world, and the noise kernel used to generate it. All kernels
+ * generate the same terrain, so the kernel only changes how fast chunks are generated. Caves are
+ * carved out of the hills unless `has_caves` is false. Until this is called, the default seed,
+ * caves and the scalar kernel are used. */
+void terrain_init(uint32_t seed, Noise_Kernel kernel, bool has_caves);
+
+/* The height of the grass surface at the column. */
+int terrain_get_height(int x, int z);
+
+Block_Type generate_block(iVec3 position);
+
+/* Fills a freshly initialized chunk with the generated terrain at the given chunk coordinate. Safe
+ * to call from several threads at once. The heightmap is sampled once per column, and the blocks
+ * are written in runs of the same type. Caves are sampled on a coarse lattice and interpolated in
+ * between. */
+void generate_chunk(Chunk *chunk, iVec3 chunk_coord);
+
+/* Generates the same blocks as generate_chunk(), but decides every block on its own. For checking
+ * and benchmarking generate_chunk() against. */
+void generate_chunk_per_voxel(Chunk *chunk, iVec3 chunk_coord);
+
+/* Places the features of the chunk, which may reach into the chunks around it. Only depends on
+ * the chunk coordinate and the seed. For World.populate. */
+void populate_chunk(iVec3 chunk_coord, Population_Queue *queue);
+
+#endif /* TERRAIN_H */
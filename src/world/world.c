@@ -2,137 +2,1508 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-static bool in_world_bounds(iVec3 chunk_coord) {
-    /* clang-format off */
-    return chunk_coord.x >= 0 && 
-           chunk_coord.y >= 0 && 
-           chunk_coord.z >= 0 && 
-           chunk_coord.x < WORLD_SIZE_X &&
-           chunk_coord.y < WORLD_SIZE_Y &&
-           chunk_coord.z < WORLD_SIZE_Z;
-    /* clang-format on */
+#include "render/meshing.h"
+
+#define DEFAULT_MAX_LOADS_PER_UPDATE 8
+#define MIN_DIRTY_QUEUE_CAPACITY 256
+#define DEFAULT_MEMORY_BUDGET ((size_t)512 * 1024 * 1024)
+#define DEFAULT_CHUNK_LAYOUT CHUNK_MAP_LAYOUT_MORTON
+
+/* Enough generation jobs are queued to keep every worker busy between updates. */
+#define GENERATION_JOBS_PER_WORKER 4
+
+/* Once the journal grows past this many bytes, the world is saved so the journal can be emptied
+ * and replaying it stays quick. The saves are spread over updates, at most
+ * JOURNAL_CHECKPOINT_SAVES_PER_UPDATE chunks each, but syncing the region files and emptying the
+ * journal at the end still happen within one update. */
+#define JOURNAL_CHECKPOINT_SIZE (4 * 1024 * 1024)
+#define JOURNAL_CHECKPOINT_SAVES_PER_UPDATE 8
+
+static void *checked_realloc(void *ptr, size_t size) {
+    void *new_ptr = realloc(ptr, size);
+    if (!new_ptr) {
+        fprintf(stderr, "World is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return new_ptr;
 }
 
-static size_t get_chunk_index(iVec3 chunk_coord) {
-    return (size_t)(chunk_coord.x + WORLD_SIZE_X * (chunk_coord.y + WORLD_SIZE_Y * chunk_coord.z));
+static int get_offset_distance_squared(iVec3 offset) {
+    return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
 }
 
-void world_push_dirty_chunk(World *world, Chunk *chunk) {
+static int compare_load_offsets(const void *a, const void *b) {
+    const iVec3 *offset_a = a;
+    const iVec3 *offset_b = b;
+
+    int distance_a = get_offset_distance_squared(*offset_a);
+    int distance_b = get_offset_distance_squared(*offset_b);
+    if (distance_a != distance_b) {
+        return distance_a < distance_b ? -1 : 1;
+    }
+
+    /* Break ties by coordinate so the load order doesn't depend on the sort implementation. */
+    if (offset_a->y != offset_b->y) {
+        return offset_a->y < offset_b->y ? -1 : 1;
+    }
+    if (offset_a->z != offset_b->z) {
+        return offset_a->z < offset_b->z ? -1 : 1;
+    }
+    if (offset_a->x != offset_b->x) {
+        return offset_a->x < offset_b->x ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static bool is_in_range(int horizontal_radius, int vertical_radius, iVec3 offset) {
+    int horizontal_distance_squared = offset.x * offset.x + offset.z * offset.z;
+    return horizontal_distance_squared <= horizontal_radius * horizontal_radius &&
+           offset.y >= -vertical_radius && offset.y <= vertical_radius;
+}
+
+static void build_load_offsets(World *world) {
+    int radius = world->load_radius;
+    int vertical_radius = world->vertical_load_radius;
+
+    size_t max_count = (size_t)(2 * radius + 1) * (size_t)(2 * radius + 1) *
+                       (size_t)(2 * vertical_radius + 1);
+    world->load_offsets = checked_realloc(NULL, sizeof(iVec3) * max_count);
+    world->load_offset_count = 0;
+
+    for (int y = -vertical_radius; y <= vertical_radius; y++) {
+        for (int z = -radius; z <= radius; z++) {
+            for (int x = -radius; x <= radius; x++) {
+                iVec3 offset = {x, y, z};
+                if (is_in_range(radius, vertical_radius, offset)) {
+                    world->load_offsets[world->load_offset_count++] = offset;
+                }
+            }
+        }
+    }
+
+    qsort(world->load_offsets, world->load_offset_count, sizeof(iVec3), compare_load_offsets);
+}
+
+bool world_create(World *world, int load_radius, int vertical_load_radius,
+                  Chunk_Generate_Fn generate, Chunk_Unload_Fn on_unload) {
+    assert(world != NULL);
+    assert(load_radius >= 0);
+    assert(vertical_load_radius >= 0);
+    assert(generate != NULL);
+
+    *world = (World){
+        .generate = generate,
+        .on_unload = on_unload,
+        .load_radius = load_radius,
+        .vertical_load_radius = vertical_load_radius,
+        .max_loads_per_update = DEFAULT_MAX_LOADS_PER_UPDATE,
+        .memory_budget = DEFAULT_MEMORY_BUDGET,
+        .mesh_budget = SIZE_MAX,
+    };
+
+    build_load_offsets(world);
+
+    return chunk_map_create(&world->chunks, world->load_offset_count * 2, DEFAULT_CHUNK_LAYOUT);
+}
+
+static int get_distance_squared(iVec3 a, iVec3 b) {
+    iVec3 delta = ivec3_sub(a, b);
+    return delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+}
+
+static void set_dirty_entry(World *world, size_t index, Dirty_Entry entry) {
+    world->dirty_queue[index] = entry;
+    entry.chunk->dirty_queue_index = index;
+}
+
+static void sift_up(World *world, size_t index) {
+    Dirty_Entry entry = world->dirty_queue[index];
+
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (world->dirty_queue[parent].distance_squared <= entry.distance_squared) {
+            break;
+        }
+
+        set_dirty_entry(world, index, world->dirty_queue[parent]);
+        index = parent;
+    }
+
+    set_dirty_entry(world, index, entry);
+}
+
+static void sift_down(World *world, size_t index) {
+    Dirty_Entry entry = world->dirty_queue[index];
+    size_t count = world->dirty_queue_count;
+
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= count) {
+            break;
+        }
+
+        if (child + 1 < count &&
+            world->dirty_queue[child + 1].distance_squared <
+                world->dirty_queue[child].distance_squared) {
+            child++;
+        }
+
+        if (entry.distance_squared <= world->dirty_queue[child].distance_squared) {
+            break;
+        }
+
+        set_dirty_entry(world, index, world->dirty_queue[child]);
+        index = child;
+    }
+
+    set_dirty_entry(world, index, entry);
+}
+
+/* Recomputes every key for the new center and restores the heap bottom-up, which is O(n). */
+static void rekey_dirty_queue(World *world, iVec3 center) {
+    world->dirty_center = center;
+
+    for (size_t i = 0; i < world->dirty_queue_count; i++) {
+        Dirty_Entry *entry = &world->dirty_queue[i];
+        entry->distance_squared = get_distance_squared(entry->chunk->coord, center);
+    }
+
+    for (size_t i = world->dirty_queue_count / 2; i-- > 0;) {
+        sift_down(world, i);
+    }
+}
+
+static void remove_from_dirty_queue(World *world, Chunk *chunk) {
+    assert(chunk->in_dirty_queue);
+
+    size_t index = chunk->dirty_queue_index;
+    assert(world->dirty_queue[index].chunk == chunk);
+
+    chunk->in_dirty_queue = false;
+    world->dirty_queue_count--;
+
+    if (index == world->dirty_queue_count) {
+        return;
+    }
+
+    /* Move the last entry into the hole, then restore the heap in whichever direction it's off. */
+    set_dirty_entry(world, index, world->dirty_queue[world->dirty_queue_count]);
+    if (index > 0 && world->dirty_queue[(index - 1) / 2].distance_squared >
+                         world->dirty_queue[index].distance_squared) {
+        sift_up(world, index);
+    } else {
+        sift_down(world, index);
+    }
+}
+
+void world_update_chunk_memory(World *world, Chunk *chunk) {
     assert(world != NULL);
     assert(chunk != NULL);
 
-    /* We already added this chunk to the dirty list. */
-    if (chunk->in_dirty_list) {
+    size_t mesh_bytes = chunk->mesh.size * sizeof(uint64_t);
+    size_t bytes = chunk_get_memory_size(chunk) + mesh_bytes;
+
+    world->resident_bytes = world->resident_bytes - chunk->resident_bytes + bytes;
+    chunk->resident_bytes = bytes;
+
+    world->resident_mesh_bytes =
+        world->resident_mesh_bytes - chunk->resident_mesh_bytes + mesh_bytes;
+    chunk->resident_mesh_bytes = mesh_bytes;
+}
+
+static bool save_chunk(World *world, Chunk *chunk) {
+    if (!world->storage || !chunk->is_modified) {
+        return true;
+    }
+
+    if (!region_storage_save_chunk(world->storage, chunk)) {
+        return false;
+    }
+
+    chunk->is_modified = false;
+    return true;
+}
+
+static void unload_chunk(World *world, Chunk *chunk) {
+    save_chunk(world, chunk);
+
+    for (int z = -1; z <= 1; z++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                iVec3 neighbor_coord = ivec3_add(chunk->coord, (iVec3){x, y, z});
+                Chunk *neighbor = chunk_map_get(&world->chunks, neighbor_coord);
+
+                if (neighbor && neighbor != chunk) {
+                    neighbor->loaded_neighbor_count--;
+                }
+            }
+        }
+    }
+
+    if (chunk->in_dirty_queue) {
+        remove_from_dirty_queue(world, chunk);
+    }
+
+    if (world->on_unload) {
+        world->on_unload(chunk);
+    }
+
+    world->resident_bytes -= chunk->resident_bytes;
+    world->resident_mesh_bytes -= chunk->resident_mesh_bytes;
+
+    Chunk *removed = chunk_map_remove(&world->chunks, chunk->coord);
+    assert(removed == chunk);
+    (void)removed;
+
+    chunk_destroy(chunk);
+    free(chunk);
+}
+
+/* Once every modified chunk is saved and on the disk, the edits in the journal aren't needed
+ * anymore. If anything failed, the journal is kept so the edits can be replayed. */
+static bool finish_save(World *world, bool saved) {
+    bool synced = region_storage_sync(world->storage);
+
+    if (saved && synced && world->journal) {
+        return edit_journal_reset(world->journal);
+    }
+
+    return saved && synced;
+}
+
+void world_destroy(World *world) {
+    assert(world != NULL);
+
+    bool saved = true;
+    for (size_t i = 0; i < world->chunks.capacity; i++) {
+        Chunk *chunk = world->chunks.entries[i].chunk;
+        if (!chunk) {
+            continue;
+        }
+
+        if (!save_chunk(world, chunk)) {
+            saved = false;
+        }
+
+        if (world->on_unload) {
+            world->on_unload(chunk);
+        }
+
+        chunk_destroy(chunk);
+        free(chunk);
+    }
+
+    if (world->storage) {
+        finish_save(world, saved);
+    }
+
+    /* Destroying the pool finishes its jobs, so every chunk being generated ends up in
+     * `generated_chunks`. None of them were in the world yet. */
+    if (world->has_generation_workers) {
+        thread_pool_destroy(&world->generation_pool);
+
+        for (size_t i = 0; i < world->generated_chunk_count; i++) {
+            chunk_destroy(world->generated_chunks[i]);
+            free(world->generated_chunks[i]);
+        }
+
+        mutex_destroy(&world->generated_mutex);
+        chunk_map_destroy(&world->generating_chunks);
+        free(world->generated_chunks);
+    }
+
+    chunk_map_destroy(&world->chunks);
+    free(world->population_queue.writes);
+    free(world->population_ready);
+    free(world->load_offsets);
+    free(world->eviction_list);
+    free(world->edit_batch);
+    free(world->dirty_queue);
+
+    *world = (World){0};
+}
+
+/* Saves the modified chunks a few at a time. Once the rest fit in one update, they are saved and
+ * the journal is emptied. Chunks edited again after they were saved are found again, so if edits
+ * keep outpacing the saves, everything is saved at once when the journal reaches twice the
+ * checkpoint size. */
+static void continue_checkpoint(World *world) {
+    if (world->journal->file_size >= 2 * JOURNAL_CHECKPOINT_SIZE) {
+        world_save(world);
         return;
     }
 
-    assert(world->dirty_list_count <= WORLD_VOLUME);
+    bool saved = true;
+    size_t saved_count = 0;
+    for (size_t i = 0; i < world->chunks.capacity; i++) {
+        Chunk *chunk = world->chunks.entries[i].chunk;
+        if (!chunk || !chunk->is_modified) {
+            continue;
+        }
 
-    world->dirty_list[world->dirty_list_count] = chunk;
-    world->dirty_list_count++;
+        if (saved_count == JOURNAL_CHECKPOINT_SAVES_PER_UPDATE) {
+            return;
+        }
+
+        if (!save_chunk(world, chunk)) {
+            saved = false;
+        }
+        saved_count++;
+    }
 
-    chunk->in_dirty_list = true;
+    finish_save(world, saved);
 }
 
-Chunk *world_pop_dirty_chunk(World *world, iVec3 player_position) {
+bool world_save(World *world) {
     assert(world != NULL);
 
-    if (world->dirty_list_count == 0) {
-        return NULL;
+    if (!world->storage) {
+        return true;
+    }
+
+    bool saved = true;
+    for (size_t i = 0; i < world->chunks.capacity; i++) {
+        Chunk *chunk = world->chunks.entries[i].chunk;
+        if (chunk && !save_chunk(world, chunk)) {
+            saved = false;
+        }
+    }
+
+    return finish_save(world, saved);
+}
+
+/* Clips the box from `min` to `max` to the chunk, in the chunk's own coordinates. */
+static void get_chunk_box(iVec3 chunk_coord, iVec3 min, iVec3 max, iVec3 *local_min,
+                          iVec3 *local_max) {
+    iVec3 origin = ivec3_scale(chunk_coord, CHUNK_SIZE);
+    iVec3 box_min = ivec3_sub(min, origin);
+    iVec3 box_max = ivec3_sub(max, origin);
+
+    local_min->x = box_min.x > 0 ? box_min.x : 0;
+    local_min->y = box_min.y > 0 ? box_min.y : 0;
+    local_min->z = box_min.z > 0 ? box_min.z : 0;
+    local_max->x = box_max.x < CHUNK_SIZE ? box_max.x : CHUNK_SIZE;
+    local_max->y = box_max.y < CHUNK_SIZE ? box_max.y : CHUNK_SIZE;
+    local_max->z = box_max.z < CHUNK_SIZE ? box_max.z : CHUNK_SIZE;
+}
+
+typedef struct Replay_Edit {
+    iVec3 chunk_coord;
+    size_t sequence;
+
+    /* The part of the journaled edit inside the chunk, in chunk coordinates. */
+    Journal_Edit edit;
+} Replay_Edit;
+
+static bool is_same_coord(iVec3 a, iVec3 b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/* Groups the edits by chunk, keeping each chunk's edits in the order they were made. */
+static int compare_replay_edits(const void *a, const void *b) {
+    const Replay_Edit *edit_a = a;
+    const Replay_Edit *edit_b = b;
+
+    if (edit_a->chunk_coord.x != edit_b->chunk_coord.x) {
+        return edit_a->chunk_coord.x < edit_b->chunk_coord.x ? -1 : 1;
+    }
+    if (edit_a->chunk_coord.y != edit_b->chunk_coord.y) {
+        return edit_a->chunk_coord.y < edit_b->chunk_coord.y ? -1 : 1;
+    }
+    if (edit_a->chunk_coord.z != edit_b->chunk_coord.z) {
+        return edit_a->chunk_coord.z < edit_b->chunk_coord.z ? -1 : 1;
     }
+    if (edit_a->sequence != edit_b->sequence) {
+        return edit_a->sequence < edit_b->sequence ? -1 : 1;
+    }
+
+    return 0;
+}
 
-    int min_distance = INT_MAX;
-    Chunk *closest_dirty = NULL;
-    size_t closest_dirty_index = 0;
+/* Returns the bit for a chunk at `offset` from another in a mask of the 27 chunks around it. */
+static uint32_t get_offset_bit(iVec3 offset) {
+    return 1u << ((offset.x + 1) + 3 * ((offset.y + 1) + 3 * (offset.z + 1)));
+}
 
-    for (size_t i = 0; i < world->dirty_list_count; i++) {
-        Chunk *chunk = world->dirty_list[i];
-        assert(chunk != NULL);
+/* Queues the feature blocks of the chunk at `source_coord`, or only those landing in `target` if
+ * it isn't NULL. */
+static void queue_population(World *world, iVec3 source_coord, const Chunk *target) {
+    Population_Queue *queue = &world->population_queue;
+    size_t first = queue->count;
+    world->populate(source_coord, queue);
 
-        iVec3 delta = ivec3_sub(player_position, chunk->coord);
-        float distance = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+    size_t kept_count = first;
+    for (size_t i = first; i < queue->count; i++) {
+        iVec3 offset = ivec3_sub(queue->writes[i].chunk_coord, source_coord);
+        assert(abs(offset.x) <= 1 && abs(offset.y) <= 1 && abs(offset.z) <= 1);
 
-        if (distance < min_distance) {
-            min_distance = distance;
-            closest_dirty = chunk;
-            closest_dirty_index = i;
+        if (!target || is_same_coord(queue->writes[i].chunk_coord, target->coord)) {
+            queue->writes[i].source_bit = get_offset_bit(ivec3_scale(offset, -1));
+            queue->writes[kept_count++] = queue->writes[i];
         }
     }
 
-    if (!closest_dirty) {
-        return NULL;
+    queue->count = kept_count;
+}
+
+/* Places the features that the chunks in `feature_sources` placed in a chunk before its first
+ * edit, in the chunk generated again to replay the edits onto. The chunk is saved with its edits,
+ * and saved chunks aren't populated when they're loaded, so otherwise it would never get them. */
+static void populate_replayed_chunk(World *world, Chunk *chunk, uint32_t feature_sources) {
+    Population_Queue *queue = &world->population_queue;
+    assert(queue->count == 0);
+
+    for (int z = -1; z <= 1; z++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                iVec3 offset = {x, y, z};
+                if (feature_sources & get_offset_bit(offset)) {
+                    queue_population(world, ivec3_add(chunk->coord, offset), chunk);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < queue->count; i++) {
+        const Population_Write *write = &queue->writes[i];
+        if (write->block != BLOCK_AIR &&
+            chunk_get_block_unsafe(chunk, write->block_coord) == BLOCK_AIR) {
+            chunk_set_block_unsafe(chunk, write->block_coord, (Block_Type)write->block);
+        }
+    }
+
+    chunk->feature_sources = feature_sources;
+    queue->count = 0;
+}
+
+bool world_replay_journal(World *world) {
+    assert(world != NULL);
+    assert(world->chunks.count == 0);
+
+    if (!world->journal) {
+        return true;
+    }
+
+    assert(world->storage != NULL);
+
+    Journal_Edit *edits;
+    size_t edit_count;
+    if (!edit_journal_read(world->journal, &edits, &edit_count)) {
+        return false;
+    }
+
+    if (edit_count == 0) {
+        return true;
+    }
+
+    /* Edits of boxes are split into one edit per chunk. */
+    size_t replay_count = 0;
+    for (size_t i = 0; i < edit_count; i++) {
+        iVec3 chunk_min = ivec3_floor_div(edits[i].min, CHUNK_SIZE);
+        iVec3 chunk_max = ivec3_floor_div(ivec3_sub(edits[i].max, (iVec3){1, 1, 1}), CHUNK_SIZE);
+        replay_count += (size_t)(chunk_max.x - chunk_min.x + 1) *
+                        (size_t)(chunk_max.y - chunk_min.y + 1) *
+                        (size_t)(chunk_max.z - chunk_min.z + 1);
+    }
+
+    Replay_Edit *replay_edits = checked_realloc(NULL, sizeof(Replay_Edit) * replay_count);
+    replay_count = 0;
+    for (size_t i = 0; i < edit_count; i++) {
+        iVec3 chunk_min = ivec3_floor_div(edits[i].min, CHUNK_SIZE);
+        iVec3 chunk_max = ivec3_floor_div(ivec3_sub(edits[i].max, (iVec3){1, 1, 1}), CHUNK_SIZE);
+
+        for (int z = chunk_min.z; z <= chunk_max.z; z++) {
+            for (int y = chunk_min.y; y <= chunk_max.y; y++) {
+                for (int x = chunk_min.x; x <= chunk_max.x; x++) {
+                    Replay_Edit *replay_edit = &replay_edits[replay_count++];
+                    replay_edit->chunk_coord = (iVec3){x, y, z};
+                    replay_edit->sequence = i;
+                    replay_edit->edit = edits[i];
+                    get_chunk_box(replay_edit->chunk_coord, edits[i].min, edits[i].max,
+                                  &replay_edit->edit.min, &replay_edit->edit.max);
+                }
+            }
+        }
     }
+    free(edits);
+
+    qsort(replay_edits, replay_count, sizeof(Replay_Edit), compare_replay_edits);
+
+    /* Each edited chunk is loaded once, has all of its edits applied, and is saved again. The
+     * chunk may have been saved after some of its edits, when it was evicted. Block and fill
+     * edits set their blocks whatever was there, so applying those again in order still ends
+     * with the blocks they left. */
+    bool saved = true;
+    size_t chunk_count = 0;
+    Chunk chunk;
+    for (size_t start = 0; start < replay_count;) {
+        iVec3 chunk_coord = replay_edits[start].chunk_coord;
+
+        size_t end = start;
+        uint32_t feature_sources = 0;
+        while (end < replay_count && is_same_coord(replay_edits[end].chunk_coord, chunk_coord)) {
+            if (replay_edits[end].edit.kind == JOURNAL_EDIT_FEATURES) {
+                feature_sources |= replay_edits[end].edit.feature_sources;
+            }
+            end++;
+        }
+
+        chunk_init(&chunk, chunk_coord);
+        if (!region_storage_load_chunk(world->storage, &chunk)) {
+            world->generate(&chunk, chunk_coord);
+
+            /* The chunk only gets the features it had when it was first edited, which go in
+             * before the edits. */
+            if (world->populate) {
+                populate_replayed_chunk(world, &chunk, feature_sources);
+            }
+        }
+
+        for (size_t i = start; i < end; i++) {
+            const Journal_Edit *edit = &replay_edits[i].edit;
+            if (edit->kind != JOURNAL_EDIT_FEATURES) {
+                chunk_fill_box_unsafe(&chunk, edit->min, edit->max, (Block_Type)edit->new_block);
+            }
+        }
+
+        if (!region_storage_save_chunk(world->storage, &chunk)) {
+            saved = false;
+        }
 
-    /* Swap and pop */
-    if (world->dirty_list_count > 1) {
-        world->dirty_list[closest_dirty_index] = world->dirty_list[world->dirty_list_count - 1];
+        chunk_destroy(&chunk);
+        chunk_count++;
+        start = end;
     }
 
-    world->dirty_list_count--;
+    free(replay_edits);
+
+    fprintf(stderr, "Replayed %zu journaled edits to %zu chunks\n", edit_count, chunk_count);
+    return finish_save(world, saved);
+}
+
+/* Along one axis, which of the chunks before, at and after an edited chunk the edits from
+ * local_min to local_max reach, as bits 0, 1 and 2. The mesh of the chunk before reads the first
+ * layer of blocks, and the chunk after reads the last. */
+static uint32_t get_axis_reach(int local_min, int local_max) {
+    return (local_min == 0 ? 1u : 0u) | 2u | (local_max == CHUNK_SIZE ? 4u : 0u);
+}
+
+/* Bit (x + 1) + 3 * ((y + 1) + 3 * (z + 1)) is set for each neighbor offset (x, y, z) whose mesh
+ * reads blocks in the box. */
+static uint32_t get_neighbor_mask(iVec3 local_min, iVec3 local_max) {
+    uint32_t reach_x = get_axis_reach(local_min.x, local_max.x);
+    uint32_t reach_y = get_axis_reach(local_min.y, local_max.y);
+    uint32_t reach_z = get_axis_reach(local_min.z, local_max.z);
+
+    uint32_t mask = 0;
+    for (uint32_t z = 0; z < 3; z++) {
+        for (uint32_t y = 0; y < 3; y++) {
+            for (uint32_t x = 0; x < 3; x++) {
+                if ((reach_x >> x) & (reach_y >> y) & (reach_z >> z) & 1) {
+                    mask |= 1u << (x + 3 * (y + 3 * z));
+                }
+            }
+        }
+    }
+
+    return mask;
+}
+
+static void add_to_edit_batch(World *world, Chunk *chunk, uint32_t neighbor_mask) {
+    chunk->edit_neighbor_mask |= neighbor_mask;
+    if (chunk->in_edit_batch) {
+        return;
+    }
+
+    if (world->edit_batch_count == world->edit_batch_capacity) {
+        world->edit_batch_capacity =
+            world->edit_batch_capacity > 0 ? world->edit_batch_capacity * 2 : 64;
+        world->edit_batch =
+            checked_realloc(world->edit_batch, sizeof(Chunk *) * world->edit_batch_capacity);
+    }
+
+    world->edit_batch[world->edit_batch_count++] = chunk;
+    chunk->in_edit_batch = true;
+}
+
+/* Marks the edited chunks and the neighbors they reach dirty, each once, and empties the batch.
+ * The chunks are marked modified too if the batch holds edits, rather than features. Returns the
+ * number of edited chunks. */
+static size_t finish_edit_batch(World *world, bool is_edit) {
+    size_t edited_count = world->edit_batch_count;
+
+    for (size_t i = 0; i < edited_count; i++) {
+        Chunk *chunk = world->edit_batch[i];
+
+        for (int z = -1; z <= 1; z++) {
+            for (int y = -1; y <= 1; y++) {
+                for (int x = -1; x <= 1; x++) {
+                    uint32_t bit = 1u << ((x + 1) + 3 * ((y + 1) + 3 * (z + 1)));
+                    if ((x == 0 && y == 0 && z == 0) || !(chunk->edit_neighbor_mask & bit)) {
+                        continue;
+                    }
+
+                    iVec3 neighbor_coord = ivec3_add(chunk->coord, (iVec3){x, y, z});
+                    Chunk *neighbor = chunk_map_get(&world->chunks, neighbor_coord);
+                    if (neighbor) {
+                        add_to_edit_batch(world, neighbor, 0);
+                    }
+                }
+            }
+        }
+    }
+
+    /* Neighbors that were edited themselves are already in the batch with their own mask. */
+    size_t changed_count = 0;
+    for (size_t i = 0; i < world->edit_batch_count; i++) {
+        Chunk *chunk = world->edit_batch[i];
+
+        if (chunk->edit_neighbor_mask != 0) {
+            chunk->is_modified |= is_edit;
+            chunk->has_edits |= is_edit;
+            world_update_chunk_memory(world, chunk);
+            changed_count++;
+        }
+
+        world_push_dirty_chunk(world, chunk);
+
+        chunk->in_edit_batch = false;
+        chunk->edit_neighbor_mask = 0;
+    }
+
+    world->edit_batch_count = 0;
+    return changed_count;
+}
+
+void population_queue_push(Population_Queue *queue, iVec3 position, Block_Type block) {
+    assert(queue != NULL);
+
+    if (queue->count == queue->capacity) {
+        queue->capacity = queue->capacity > 0 ? queue->capacity * 2 : 256;
+        queue->writes = checked_realloc(queue->writes, sizeof(Population_Write) * queue->capacity);
+    }
+
+    queue->writes[queue->count] = (Population_Write){
+        .chunk_coord = ivec3_floor_div(position, CHUNK_SIZE),
+        .block_coord = ivec3_mod(position, CHUNK_SIZE),
+        .sequence = queue->count,
+        .block = (uint8_t)block,
+    };
+    queue->count++;
+}
+
+static void push_population_ready(World *world, Chunk *chunk) {
+    if (world->population_ready_count == world->population_ready_capacity) {
+        world->population_ready_capacity =
+            world->population_ready_capacity > 0 ? world->population_ready_capacity * 2 : 64;
+        world->population_ready = checked_realloc(
+            world->population_ready, sizeof(Chunk *) * world->population_ready_capacity);
+    }
+
+    world->population_ready[world->population_ready_count++] = chunk;
+}
+
+/* Adds a chunk whose blocks are ready to the world. */
+static void add_loaded_chunk(World *world, Chunk *chunk) {
+    chunk->last_access = world->tick;
+    world_update_chunk_memory(world, chunk);
+
+    chunk_map_insert(&world->chunks, chunk);
+    world_push_dirty_chunk(world, chunk);
+
+    /* Loaded neighbors were meshed with this chunk reading as solid, so their faces and ambient
+     * occlusion along the shared boundary are out of date. Neighbors still waiting in the dirty
+     * queue will see the new chunk when they get meshed.
+     *
+     * Neighbors that placed their features before this chunk was generated again place the parts
+     * that land in it again. */
+    for (int z = -1; z <= 1; z++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                if (x == 0 && y == 0 && z == 0) {
+                    continue;
+                }
+
+                iVec3 neighbor_coord = ivec3_add(chunk->coord, (iVec3){x, y, z});
+                Chunk *neighbor = chunk_map_get(&world->chunks, neighbor_coord);
+                if (!neighbor) {
+                    continue;
+                }
+
+                if (!neighbor->in_dirty_queue) {
+                    world_push_dirty_chunk(world, neighbor);
+                }
+
+                chunk->loaded_neighbor_count++;
+                neighbor->loaded_neighbor_count++;
+
+                if (!world->populate) {
+                    continue;
+                }
+
+                if (neighbor->is_populated && !chunk->has_edits) {
+                    queue_population(world, neighbor->coord, chunk);
+                } else if (neighbor->loaded_neighbor_count == 26) {
+                    push_population_ready(world, neighbor);
+                }
+            }
+        }
+    }
+
+    if (world->populate && chunk->loaded_neighbor_count == 26) {
+        push_population_ready(world, chunk);
+    }
+}
+
+typedef struct Generation_Job {
+    World *world;
+    Chunk *chunk;
+} Generation_Job;
+
+/* Runs on a generation worker. The chunk isn't in the world yet, so nothing else touches it. */
+static void generation_job(void *user_data, size_t worker_index) {
+    (void)worker_index;
+
+    Generation_Job *job = user_data;
+    World *world = job->world;
+    Chunk *chunk = job->chunk;
+    free(job);
+
+    world->generate(chunk, chunk->coord);
+
+    mutex_lock(&world->generated_mutex);
+
+    if (world->generated_chunk_count == world->generated_chunk_capacity) {
+        world->generated_chunk_capacity =
+            world->generated_chunk_capacity > 0 ? world->generated_chunk_capacity * 2 : 64;
+        world->generated_chunks = checked_realloc(
+            world->generated_chunks, sizeof(Chunk *) * world->generated_chunk_capacity);
+    }
+
+    world->generated_chunks[world->generated_chunk_count++] = chunk;
+
+    mutex_unlock(&world->generated_mutex);
+}
+
+/* Adds the chunks the generation workers have finished, in the order they finished. */
+static void add_generated_chunks(World *world) {
+    mutex_lock(&world->generated_mutex);
+
+    for (size_t i = 0; i < world->generated_chunk_count; i++) {
+        Chunk *chunk = world->generated_chunks[i];
+        chunk_map_remove(&world->generating_chunks, chunk->coord);
+        add_loaded_chunk(world, chunk);
+    }
+
+    world->generated_chunk_count = 0;
+
+    mutex_unlock(&world->generated_mutex);
+}
 
-    closest_dirty->in_dirty_list = false;
+bool world_start_generation_workers(World *world, size_t thread_count) {
+    assert(world != NULL);
+    assert(!world->has_generation_workers);
+    assert(thread_count > 0);
+
+    if (!chunk_map_create(&world->generating_chunks, 0, DEFAULT_CHUNK_LAYOUT)) {
+        return false;
+    }
+
+    if (!thread_pool_create(&world->generation_pool, thread_count)) {
+        chunk_map_destroy(&world->generating_chunks);
+        return false;
+    }
+
+    mutex_create(&world->generated_mutex);
+    world->max_generation_jobs = thread_count * GENERATION_JOBS_PER_WORKER;
+    world->has_generation_workers = true;
+    return true;
+}
+
+bool world_is_loading(const World *world) {
+    assert(world != NULL);
+
+    return !world->has_center || world->load_cursor < world->load_offset_count ||
+           (world->has_generation_workers && world->generating_chunks.count > 0);
+}
+
+/* Returns true if a chunk is at the coordinate, or on its way. */
+static bool is_chunk_loaded_or_generating(const World *world, iVec3 chunk_coord) {
+    return chunk_map_get(&world->chunks, chunk_coord) ||
+           (world->has_generation_workers &&
+            chunk_map_get(&world->generating_chunks, chunk_coord));
+}
+
+static void load_chunk(World *world, iVec3 chunk_coord) {
+    Chunk *chunk = malloc(sizeof(Chunk));
+    if (!chunk) {
+        fprintf(stderr, "World is out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    chunk_init(chunk, chunk_coord);
+
+    /* Only chunks that were edited are ever saved, the rest are generated again. */
+    if (world->storage && region_storage_load_chunk(world->storage, chunk)) {
+        chunk->has_edits = true;
+        add_loaded_chunk(world, chunk);
+        return;
+    }
+
+    if (!world->has_generation_workers) {
+        world->generate(chunk, chunk_coord);
+        add_loaded_chunk(world, chunk);
+        return;
+    }
+
+    Generation_Job *job = checked_realloc(NULL, sizeof(Generation_Job));
+    *job = (Generation_Job){world, chunk};
+
+    chunk_map_insert(&world->generating_chunks, chunk);
+    thread_pool_submit(&world->generation_pool, generation_job, job);
+}
+
+static int compare_last_access(const void *a, const void *b) {
+    const Chunk *chunk_a = *(Chunk *const *)a;
+    const Chunk *chunk_b = *(Chunk *const *)b;
+
+    if (chunk_a->last_access != chunk_b->last_access) {
+        return chunk_a->last_access < chunk_b->last_access ? -1 : 1;
+    }
+
+    return 0;
+}
+
+bool world_is_chunk_in_range(const World *world, const Chunk *chunk) {
+    assert(world != NULL);
+    assert(chunk != NULL);
+
+    iVec3 offset = ivec3_sub(chunk->coord, world->center);
+    return world->has_center &&
+           is_in_range(world->load_radius, world->vertical_load_radius, offset);
+}
+
+/* Chunks in range are marked as used, and the rest become candidates for eviction. Chunks that
+ * just left the range were used most recently, so they are evicted last, and moving back and forth
+ * across a chunk border doesn't keep unloading and reloading the same chunks. */
+static void build_eviction_list(World *world) {
+    world->eviction_list_count = 0;
+    world->eviction_cursor = 0;
+
+    for (size_t i = 0; i < world->chunks.capacity; i++) {
+        Chunk *chunk = world->chunks.entries[i].chunk;
+        if (!chunk) {
+            continue;
+        }
+
+        if (world_is_chunk_in_range(world, chunk)) {
+            chunk->last_access = world->tick;
+            continue;
+        }
+
+        if (world->eviction_list_count == world->eviction_list_capacity) {
+            world->eviction_list_capacity =
+                world->eviction_list_capacity > 0 ? world->eviction_list_capacity * 2 : 64;
+            world->eviction_list = checked_realloc(
+                world->eviction_list, sizeof(Chunk *) * world->eviction_list_capacity);
+        }
+
+        world->eviction_list[world->eviction_list_count++] = chunk;
+    }
+
+    if (world->eviction_list_count > 0) {
+        qsort(world->eviction_list, world->eviction_list_count, sizeof(Chunk *),
+              compare_last_access);
+    }
+}
+
+/* Evicted chunks are saved first if they were modified, and their meshes are released through
+ * the unload callback. Chunks that fail to save are kept so their edits aren't lost. */
+static void evict_chunks(World *world) {
+    while ((world->resident_bytes > world->memory_budget ||
+            world->resident_mesh_bytes > world->mesh_budget) &&
+           world->eviction_cursor < world->eviction_list_count) {
+        Chunk *chunk = world->eviction_list[world->eviction_cursor++];
+        if (!save_chunk(world, chunk)) {
+            continue;
+        }
+
+        unload_chunk(world, chunk);
+        world->evicted_chunk_count++;
+    }
+}
+
+/* Groups the writes by chunk, keeping each chunk's writes in the order they were queued. */
+static int compare_population_writes(const void *a, const void *b) {
+    const Population_Write *write_a = a;
+    const Population_Write *write_b = b;
+
+    if (write_a->chunk_coord.x != write_b->chunk_coord.x) {
+        return write_a->chunk_coord.x < write_b->chunk_coord.x ? -1 : 1;
+    }
+    if (write_a->chunk_coord.y != write_b->chunk_coord.y) {
+        return write_a->chunk_coord.y < write_b->chunk_coord.y ? -1 : 1;
+    }
+    if (write_a->chunk_coord.z != write_b->chunk_coord.z) {
+        return write_a->chunk_coord.z < write_b->chunk_coord.z ? -1 : 1;
+    }
+    if (write_a->sequence != write_b->sequence) {
+        return write_a->sequence < write_b->sequence ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/* Places the features of the chunks whose neighbors have all been loaded, along with the writes
+ * queued for chunks that were generated again, as one batch. */
+static void populate_chunks(World *world) {
+    for (size_t i = 0; i < world->population_ready_count; i++) {
+        Chunk *chunk = world->population_ready[i];
+        if (chunk->is_populated || chunk->loaded_neighbor_count < 26) {
+            continue;
+        }
+
+        chunk->is_populated = true;
+        queue_population(world, chunk->coord, NULL);
+    }
+
+    world->population_ready_count = 0;
+
+    Population_Queue *queue = &world->population_queue;
+    if (queue->count == 0) {
+        return;
+    }
+
+    qsort(queue->writes, queue->count, sizeof(Population_Write), compare_population_writes);
+
+    Chunk *chunk = NULL;
+    for (size_t i = 0; i < queue->count; i++) {
+        const Population_Write *write = &queue->writes[i];
+        if (i == 0 || !is_same_coord(write->chunk_coord, queue->writes[i - 1].chunk_coord)) {
+            chunk = chunk_map_get(&world->chunks, write->chunk_coord);
+        }
+
+        if (!chunk || chunk->has_edits) {
+            continue;
+        }
+
+        chunk->feature_sources |= write->source_bit;
+        if (write->block == BLOCK_AIR ||
+            chunk_get_block_unsafe(chunk, write->block_coord) != BLOCK_AIR) {
+            continue;
+        }
+
+        chunk_set_block_unsafe(chunk, write->block_coord, (Block_Type)write->block);
+
+        iVec3 block_max = ivec3_add(write->block_coord, (iVec3){1, 1, 1});
+        add_to_edit_batch(world, chunk, get_neighbor_mask(write->block_coord, block_max));
+    }
+
+    queue->count = 0;
+    finish_edit_batch(world, false);
+}
+
+void world_update_loaded_chunks(World *world, iVec3 center_chunk_coord) {
+    assert(world != NULL);
+
+    iVec3 old_center = world->center;
+    bool center_moved = !world->has_center || old_center.x != center_chunk_coord.x ||
+                        old_center.y != center_chunk_coord.y ||
+                        old_center.z != center_chunk_coord.z;
+
+    world->tick++;
+
+    if (center_moved) {
+        world->center = center_chunk_coord;
+        world->has_center = true;
+        world->load_cursor = 0;
+
+        build_eviction_list(world);
+    }
+
+    if (world->has_generation_workers) {
+        add_generated_chunks(world);
+    }
+
+    /* With generation workers, loads are cheap to start, so only the number of chunks being
+     * generated limits them. */
+    size_t load_count = 0;
+    size_t max_load_count = world->has_generation_workers ? SIZE_MAX : world->max_loads_per_update;
+    while (world->load_cursor < world->load_offset_count) {
+        iVec3 offset = world->load_offsets[world->load_cursor];
+        iVec3 chunk_coord = ivec3_add(world->center, offset);
+
+        if (!is_chunk_loaded_or_generating(world, chunk_coord)) {
+            bool is_generation_full =
+                world->has_generation_workers &&
+                world->generating_chunks.count >= world->max_generation_jobs;
+            if (load_count == max_load_count || is_generation_full) {
+                break;
+            }
+
+            load_chunk(world, chunk_coord);
+            load_count++;
+        }
+
+        world->load_cursor++;
+    }
+
+    if (world->populate) {
+        populate_chunks(world);
+    }
+
+    evict_chunks(world);
+
+    if (world->journal) {
+        if (edit_journal_is_commit_due(world->journal)) {
+            edit_journal_commit(world->journal);
+        }
+
+        if (world->journal->file_size >= JOURNAL_CHECKPOINT_SIZE) {
+            continue_checkpoint(world);
+        }
+    }
+}
+
+void world_push_dirty_chunk(World *world, Chunk *chunk) {
+    assert(world != NULL);
+    assert(chunk != NULL);
+
+    /* Any mesh currently being built for this chunk is now out of date. */
+    chunk->version = ++world->next_version;
+
+    /* We already added this chunk to the dirty queue. */
+    if (chunk->in_dirty_queue) {
+        return;
+    }
+
+    if (world->dirty_queue_count == world->dirty_queue_capacity) {
+        world->dirty_queue_capacity = world->dirty_queue_capacity > 0
+                                          ? world->dirty_queue_capacity * 2
+                                          : MIN_DIRTY_QUEUE_CAPACITY;
+        world->dirty_queue = checked_realloc(world->dirty_queue,
+                                             sizeof(Dirty_Entry) * world->dirty_queue_capacity);
+    }
+
+    Dirty_Entry entry = {
+        .distance_squared = get_distance_squared(chunk->coord, world->dirty_center),
+        .chunk = chunk,
+    };
+
+    size_t index = world->dirty_queue_count++;
+    set_dirty_entry(world, index, entry);
+    sift_up(world, index);
+
+    chunk->in_dirty_queue = true;
+}
+
+Chunk *world_pop_dirty_chunk(World *world, iVec3 player_position) {
+    assert(world != NULL);
+
+    if (world->dirty_queue_count == 0) {
+        return NULL;
+    }
+
+    iVec3 center = world->dirty_center;
+    if (center.x != player_position.x || center.y != player_position.y ||
+        center.z != player_position.z) {
+        rekey_dirty_queue(world, player_position);
+    }
+
+    Chunk *closest_dirty = world->dirty_queue[0].chunk;
+    remove_from_dirty_queue(world, closest_dirty);
     return closest_dirty;
 }
 
 Chunk *world_get_chunk(World *world, iVec3 chunk_coord) {
     assert(world != NULL);
 
-    if (!in_world_bounds(chunk_coord)) {
-        return NULL;
+    Chunk *chunk = chunk_map_get(&world->chunks, chunk_coord);
+    if (chunk) {
+        chunk->last_access = world->tick;
     }
 
-    return &world->chunk[get_chunk_index(chunk_coord)];
+    return chunk;
 }
 
 Block_Type world_get_block(const World *world, iVec3 position) {
     assert(world != NULL);
 
     iVec3 chunk_coord = ivec3_floor_div(position, CHUNK_SIZE);
-    if (!in_world_bounds(chunk_coord)) {
+    const Chunk *chunk = chunk_map_get(&world->chunks, chunk_coord);
+    if (!chunk) {
         return BLOCK_DIRT;
     }
 
-    const Chunk *chunk = &world->chunk[get_chunk_index(chunk_coord)];
-
     iVec3 block_coord = ivec3_mod(position, CHUNK_SIZE);
     return chunk_get_block_unsafe(chunk, block_coord);
 }
 
+/* Called when an edit changes a chunk's blocks, before the edit is journaled. A chunk generated
+ * again to replay its edits onto has to get the features it had before its first edit, and no
+ * others, so those are journaled ahead of it. */
+static void mark_chunk_edited(World *world, Chunk *chunk) {
+    if (chunk->has_edits) {
+        return;
+    }
+
+    chunk->has_edits = true;
+    if (!world->journal || !world->populate) {
+        return;
+    }
+
+    Journal_Edit edit = {
+        .kind = JOURNAL_EDIT_FEATURES,
+        .min = ivec3_scale(chunk->coord, CHUNK_SIZE),
+        .max = ivec3_add(ivec3_scale(chunk->coord, CHUNK_SIZE), (iVec3){1, 1, 1}),
+        .feature_sources = chunk->feature_sources,
+    };
+    edit_journal_append(world->journal, &edit);
+}
+
+static void journal_block_edit(World *world, iVec3 position, Block_Type old_block,
+                               Block_Type new_block) {
+    Journal_Edit edit = {
+        .kind = JOURNAL_EDIT_BLOCK,
+        .min = position,
+        .max = ivec3_add(position, (iVec3){1, 1, 1}),
+        .old_block = (uint8_t)old_block,
+        .new_block = (uint8_t)new_block,
+    };
+    edit_journal_append(world->journal, &edit);
+}
+
 void world_set_block(World *world, iVec3 position, Block_Type new_block) {
     assert(world != NULL);
 
-    iVec3 chunk_coord = ivec3_floor_div(position, CHUNK_SIZE);
-    Chunk *chunk = world_get_chunk(world, chunk_coord);
-    if (!chunk) {
+    /* A batch of one, so a single edit skips setting a block to what it already is and dirties
+     * the same neighbors as the batched edits. */
+    world_set_blocks(world, &position, &new_block, 1);
+}
+
+static void journal_box_edit(World *world, iVec3 chunk_coord, iVec3 local_min, iVec3 local_max,
+                             Block_Type type) {
+    if (!world->journal) {
         return;
     }
 
-    iVec3 block_coord = ivec3_mod(position, CHUNK_SIZE);
-    chunk_set_block_unsafe(chunk, block_coord, new_block);
+    iVec3 origin = ivec3_scale(chunk_coord, CHUNK_SIZE);
+    Journal_Edit edit = {
+        .kind = JOURNAL_EDIT_FILL,
+        .min = ivec3_add(origin, local_min),
+        .max = ivec3_add(origin, local_max),
+        .new_block = (uint8_t)type,
+    };
+    edit_journal_append(world->journal, &edit);
+}
 
-    world_push_dirty_chunk(world, chunk);
+/* What a replacement changes depends on the blocks it finds, so replaying it over a chunk that was
+ * saved after later edits could replace their blocks too. It is journaled before it is made, as
+ * fills of `to` over the runs of `from` blocks along X in the box, which are the blocks it
+ * changes. */
+static void journal_replaced_blocks(World *world, Chunk *chunk, iVec3 local_min,
+                                    iVec3 local_max, Block_Type from, Block_Type to) {
+    if (!world->journal || from == to || chunk->block_counts[from] == 0) {
+        return;
+    }
 
-    /* If a block was set on the edge of this chunk, then we also need to mark the affected
-     * neighboring chunks as dirty, as their meshes are now invalid. */
-    bool affected_neighbors[DIRECTION_COUNT] = {
-        [DIR_POSITIVE_X] = block_coord.x == CHUNK_SIZE - 1,
-        [DIR_POSITIVE_Y] = block_coord.y == CHUNK_SIZE - 1,
-        [DIR_POSITIVE_Z] = block_coord.z == CHUNK_SIZE - 1,
-        [DIR_NEGATIVE_X] = block_coord.x == 0,
-        [DIR_NEGATIVE_Y] = block_coord.y == 0,
-        [DIR_NEGATIVE_Z] = block_coord.z == 0,
-    };
+    iVec3 origin = ivec3_scale(chunk->coord, CHUNK_SIZE);
+    uint8_t row[CHUNK_SIZE];
+
+    for (int z = local_min.z; z < local_max.z; z++) {
+        for (int y = local_min.y; y < local_max.y; y++) {
+            chunk_decode_unsafe(chunk, (iVec3){local_min.x, y, z},
+                                (iVec3){local_max.x, y + 1, z + 1}, row, CHUNK_SIZE,
+                                CHUNK_SIZE);
+
+            int width = local_max.x - local_min.x;
+            for (int x = 0; x < width;) {
+                if (row[x] != from) {
+                    x++;
+                    continue;
+                }
+
+                int run_start = x;
+                while (x < width && row[x] == from) {
+                    x++;
+                }
+
+                mark_chunk_edited(world, chunk);
+
+                Journal_Edit edit = {
+                    .kind = JOURNAL_EDIT_FILL,
+                    .min = ivec3_add(origin, (iVec3){local_min.x + run_start, y, z}),
+                    .max = ivec3_add(origin, (iVec3){local_min.x + x, y + 1, z + 1}),
+                    .new_block = (uint8_t)to,
+                };
+                edit_journal_append(world->journal, &edit);
+            }
+        }
+    }
+}
+
+/* Applies a fill, or a replacement of `from` if `is_replace`, to every loaded chunk in the box. */
+static size_t edit_box(World *world, iVec3 min, iVec3 max, bool is_replace, Block_Type from,
+                       Block_Type to) {
+    if (min.x >= max.x || min.y >= max.y || min.z >= max.z) {
+        return 0;
+    }
+
+    iVec3 chunk_min = ivec3_floor_div(min, CHUNK_SIZE);
+    iVec3 chunk_max = ivec3_floor_div(ivec3_sub(max, (iVec3){1, 1, 1}), CHUNK_SIZE);
+
+    for (int z = chunk_min.z; z <= chunk_max.z; z++) {
+        for (int y = chunk_min.y; y <= chunk_max.y; y++) {
+            for (int x = chunk_min.x; x <= chunk_max.x; x++) {
+                iVec3 chunk_coord = {x, y, z};
+                Chunk *chunk = world_get_chunk(world, chunk_coord);
+                if (!chunk) {
+                    continue;
+                }
+
+                iVec3 local_min;
+                iVec3 local_max;
+                get_chunk_box(chunk_coord, min, max, &local_min, &local_max);
+
+                /* Only the chunks that were loaded are edited, so each is journaled on its own. */
+                bool changed;
+                if (is_replace) {
+                    journal_replaced_blocks(world, chunk, local_min, local_max, from, to);
+                    changed = chunk_replace_in_box_unsafe(chunk, local_min, local_max, from, to);
+                } else {
+                    changed = chunk_fill_box_unsafe(chunk, local_min, local_max, to);
+                    if (changed) {
+                        mark_chunk_edited(world, chunk);
+                        journal_box_edit(world, chunk_coord, local_min, local_max, to);
+                    }
+                }
+
+                if (!changed) {
+                    continue;
+                }
+                add_to_edit_batch(world, chunk, get_neighbor_mask(local_min, local_max));
+            }
+        }
+    }
+
+    return finish_edit_batch(world, true);
+}
+
+size_t world_fill_box(World *world, iVec3 min, iVec3 max, Block_Type type) {
+    assert(world != NULL);
+    return edit_box(world, min, max, false, BLOCK_AIR, type);
+}
+
+size_t world_replace_in_box(World *world, iVec3 min, iVec3 max, Block_Type from, Block_Type to) {
+    assert(world != NULL);
+    return edit_box(world, min, max, true, from, to);
+}
+
+size_t world_set_blocks(World *world, const iVec3 *positions, const Block_Type *types,
+                        size_t count) {
+    assert(world != NULL);
+    assert(positions != NULL || count == 0);
+    assert(types != NULL || count == 0);
+
+    /* Consecutive positions tend to be in the same chunk, so the last lookup is reused. */
+    Chunk *chunk = NULL;
+    iVec3 chunk_coord = {0, 0, 0};
+    bool has_lookup = false;
+
+    for (size_t i = 0; i < count; i++) {
+        iVec3 position_chunk_coord = ivec3_floor_div(positions[i], CHUNK_SIZE);
+        if (!has_lookup || !is_same_coord(position_chunk_coord, chunk_coord)) {
+            chunk_coord = position_chunk_coord;
+            chunk = world_get_chunk(world, chunk_coord);
+            has_lookup = true;
+        }
+
+        if (!chunk) {
+            continue;
+        }
+
+        iVec3 block_coord = ivec3_mod(positions[i], CHUNK_SIZE);
+        Block_Type old_block = chunk_get_block_unsafe(chunk, block_coord);
+        if (old_block == types[i]) {
+            continue;
+        }
+
+        mark_chunk_edited(world, chunk);
+        chunk_set_block_unsafe(chunk, block_coord, types[i]);
+
+        if (world->journal) {
+            journal_block_edit(world, positions[i], old_block, types[i]);
+        }
+
+        iVec3 block_max = ivec3_add(block_coord, (iVec3){1, 1, 1});
+        add_to_edit_batch(world, chunk, get_neighbor_mask(block_coord, block_max));
+    }
+
+    return finish_edit_batch(world, true);
+}
+
+/* Along one axis, the part of neighbor 0, 1 or 2 that falls inside the padded meshing volume:
+ * the last layer of the chunk before, all of the chunk itself, or the first layer of the chunk
+ * after. */
+static void get_padded_range(int neighbor, int *local_min, int *local_max, int *padded_min) {
+    if (neighbor == 0) {
+        *local_min = CHUNK_SIZE - 1;
+        *local_max = CHUNK_SIZE;
+        *padded_min = 0;
+    } else if (neighbor == 1) {
+        *local_min = 0;
+        *local_max = CHUNK_SIZE;
+        *padded_min = 1;
+    } else {
+        *local_min = 0;
+        *local_max = 1;
+        *padded_min = MESHING_DATA_SIZE - 1;
+    }
+}
+
+/* Index of a chunk in a 3x3x3 neighborhood, given its offset from the center in 0..2. */
+static int get_neighborhood_index(int x, int y, int z) {
+    return x + 3 * (y + 3 * z);
+}
+
+/* `chunks` holds the 27 chunks of the neighborhood, NULL for those that aren't loaded. */
+static void decode_meshing_data(const Chunk *const *chunks, Meshing_Data *data) {
+    const size_t row_stride = MESHING_DATA_SIZE;
+    const size_t slice_stride = MESHING_DATA_SIZE * MESHING_DATA_SIZE;
+
+    /* Each of the 27 chunks decodes its part of the padded volume in one call. */
+    for (int z = 0; z < 3; z++) {
+        for (int y = 0; y < 3; y++) {
+            for (int x = 0; x < 3; x++) {
+                iVec3 min;
+                iVec3 max;
+                iVec3 padded_min;
+                get_padded_range(x, &min.x, &max.x, &padded_min.x);
+                get_padded_range(y, &min.y, &max.y, &padded_min.y);
+                get_padded_range(z, &min.z, &max.z, &padded_min.z);
+
+                size_t offset = (size_t)padded_min.x + (size_t)padded_min.y * row_stride +
+                                (size_t)padded_min.z * slice_stride;
+                uint8_t *out = &data->blocks[offset];
+
+                const Chunk *chunk = chunks[get_neighborhood_index(x, y, z)];
+                if (chunk) {
+                    chunk_decode_unsafe(chunk, min, max, out, row_stride, slice_stride);
+                    continue;
+                }
+
+                /* Chunks that aren't loaded read as BLOCK_DIRT, matching world_get_block(). */
+                for (int local_z = 0; local_z < max.z - min.z; local_z++) {
+                    for (int local_y = 0; local_y < max.y - min.y; local_y++) {
+                        size_t row = (size_t)local_y * row_stride + (size_t)local_z * slice_stride;
+                        memset(&out[row], BLOCK_DIRT, (size_t)(max.x - min.x));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void world_get_meshing_data(const World *world, iVec3 chunk_coord, Meshing_Data *data) {
+    assert(world != NULL);
+    assert(data != NULL);
+
+    const Chunk *chunks[27];
+    for (int z = 0; z < 3; z++) {
+        for (int y = 0; y < 3; y++) {
+            for (int x = 0; x < 3; x++) {
+                iVec3 coord = ivec3_add(chunk_coord, (iVec3){x - 1, y - 1, z - 1});
+                chunks[get_neighborhood_index(x, y, z)] = chunk_map_get(&world->chunks, coord);
+            }
+        }
+    }
+
+    decode_meshing_data(chunks, data);
+}
+
+void world_snapshot_neighborhood(const World *world, iVec3 chunk_coord,
+                                 Chunk_Neighborhood *neighborhood) {
+    assert(world != NULL);
+    assert(neighborhood != NULL);
+
+    neighborhood->chunk_coord = chunk_coord;
+
+    for (int z = 0; z < 3; z++) {
+        for (int y = 0; y < 3; y++) {
+            for (int x = 0; x < 3; x++) {
+                int index = get_neighborhood_index(x, y, z);
+                iVec3 coord = ivec3_add(chunk_coord, (iVec3){x - 1, y - 1, z - 1});
+
+                const Chunk *chunk = chunk_map_get(&world->chunks, coord);
+                neighborhood->is_loaded[index] = chunk != NULL;
+                if (chunk) {
+                    chunk_snapshot(chunk, &neighborhood->chunks[index]);
+                }
+            }
+        }
+    }
+}
+
+void world_release_neighborhood(Chunk_Neighborhood *neighborhood) {
+    assert(neighborhood != NULL);
+
+    for (int i = 0; i < 27; i++) {
+        if (neighborhood->is_loaded[i]) {
+            chunk_destroy(&neighborhood->chunks[i]);
+            neighborhood->is_loaded[i] = false;
+        }
+    }
+}
+
+void world_get_neighborhood_meshing_data(const Chunk_Neighborhood *neighborhood,
+                                         Meshing_Data *data) {
+    assert(neighborhood != NULL);
+    assert(data != NULL);
+
+    const Chunk *chunks[27];
+    for (int i = 0; i < 27; i++) {
+        chunks[i] = neighborhood->is_loaded[i] ? &neighborhood->chunks[i] : NULL;
+    }
+
+    decode_meshing_data(chunks, data);
+}
+
+bool world_is_chunk_mesh_empty(const World *world, const Chunk *chunk) {
+    assert(world != NULL);
+    assert(chunk != NULL);
+
+    Block_Type uniform_type;
+    if (!chunk_is_uniform(chunk, &uniform_type)) {
+        return false;
+    }
+
+    if (uniform_type == BLOCK_AIR) {
+        return true;
+    }
+
+    if (get_block_properties(uniform_type)->is_transparent) {
+        return false;
+    }
 
     for (Direction dir = 0; dir < DIRECTION_COUNT; dir++) {
-        if (!affected_neighbors[dir]) {
+        iVec3 neighbor_coord = ivec3_add(chunk->coord, direction_to_ivec3(dir));
+
+        /* Chunks that aren't loaded are solid dirt. */
+        const Chunk *neighbor = chunk_map_get(&world->chunks, neighbor_coord);
+        if (!neighbor) {
             continue;
         }
 
-        iVec3 neighbor_chunk_coord = ivec3_add(chunk_coord, direction_to_ivec3(dir));
-        Chunk *neighbor = world_get_chunk(world, neighbor_chunk_coord);
-        if (neighbor != NULL) {
-            world_push_dirty_chunk(world, neighbor);
+        if (!chunk_is_face_opaque(neighbor, get_opposite_direction(dir))) {
+            return false;
         }
     }
+
+    return true;
 }
@@ -2,25 +2,226 @@
 #define WORLD_H
 
 #include "chunk.h"
+#include "chunk_map.h"
+#include "journal.h"
+#include "region.h"
+#include "utils/thread_pool.h"
 
-#define WORLD_SIZE_X (32)
-#define WORLD_SIZE_Y (8)
-#define WORLD_SIZE_Z (32)
-#define WORLD_VOLUME (WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z)
+/* The padded block box the mesher works on, see render/meshing.h. */
+struct Meshing_Data;
+
+/* Fills a freshly initialized chunk when it is loaded. */
+typedef void (*Chunk_Generate_Fn)(Chunk *chunk, iVec3 chunk_coord);
+
+/* Called right before a chunk is unloaded and freed, to release anything that refers to it. */
+typedef void (*Chunk_Unload_Fn)(Chunk *chunk);
+
+/* Block writes of features that may cross chunk borders, grouped by the chunk they land in when
+ * they are applied. */
+typedef struct Population_Write {
+    iVec3 chunk_coord;
+    iVec3 block_coord;
+    size_t sequence;
+    uint8_t block;
+
+    /* The bit of the chunk that placed the write in the written chunk's feature_sources. Set by
+     * the world. */
+    uint32_t source_bit;
+} Population_Write;
+
+typedef struct Population_Queue {
+    Population_Write *writes;
+    size_t count;
+    size_t capacity;
+} Population_Queue;
+
+/* Queues a feature block at a world position. */
+void population_queue_push(Population_Queue *queue, iVec3 position, Block_Type block);
+
+/* Places the features of the chunk at `chunk_coord` by queuing their blocks. The blocks must lie in
+ * the chunk or the 26 around it. Features must only depend on the coordinate and the world seed,
+ * since the writes into a chunk are queued again whenever it is generated again. */
+typedef void (*Chunk_Populate_Fn)(iVec3 chunk_coord, Population_Queue *queue);
+
+/* Snapshots of a chunk and the 26 chunks around it, which stay unchanged while the world is
+ * edited and can be read on any thread. Indexed by x + 3 * (y + 3 * z) for offsets from -1 to 1,
+ * shifted to 0 to 2, so the chunk itself is at 13. */
+typedef struct Chunk_Neighborhood {
+    iVec3 chunk_coord;
+    Chunk chunks[27];
+    bool is_loaded[27];
+} Chunk_Neighborhood;
+
+typedef struct Dirty_Entry {
+    int distance_squared;
+    Chunk *chunk;
+} Dirty_Entry;
 
 typedef struct World {
-    Chunk chunk[WORLD_VOLUME];
+    Chunk_Map chunks;
+
+    Chunk_Generate_Fn generate;
+    Chunk_Unload_Fn on_unload;
+
+    /* Runs once a chunk and all 26 chunks around it are loaded. NULL if the world has no
+     * features. Feature blocks only replace air, and chunks with edits are left alone. The writes
+     * of every chunk populated in an update are applied together, so each chunk they reach is
+     * marked dirty once. */
+    Chunk_Populate_Fn populate;
+    Population_Queue population_queue;
+    Chunk **population_ready;
+    size_t population_ready_count;
+    size_t population_ready_capacity;
+
+    /* Where modified chunks are saved when they are unloaded, and loaded from instead of being
+     * generated. NULL if the world isn't saved. */
+    Region_Storage *storage;
+
+    /* Where every block edit is logged until its chunk is saved, so edits survive a crash. NULL
+     * if edits aren't journaled, and must be NULL if there's no storage. */
+    Edit_Journal *journal;
+
+    /* Chunks are kept loaded within `load_radius` chunks horizontally and `vertical_load_radius`
+     * chunks vertically of the center. At most `max_loads_per_update` chunks are generated per
+     * world_update_loaded_chunks() call. */
+    int load_radius;
+    int vertical_load_radius;
+    size_t max_loads_per_update;
+
+    iVec3 center;
+    bool has_center;
+
+    /* Chunk offsets within the load radius, sorted by distance so the closest chunks are loaded
+     * first. Chunks before `load_cursor` are known to be loaded for the current center. */
+    iVec3 *load_offsets;
+    size_t load_offset_count;
+    size_t load_cursor;
+
+    /* Chunks that leave the load radius stay resident until the memory they and their meshes use
+     * exceeds `memory_budget` bytes, and are then evicted least recently used first. Chunks in the
+     * load radius are never evicted, so the budget can be exceeded if it is too small for them.
+     * Meshes also have to fit in a fixed size buffer, so chunks are evicted the same way while
+     * their meshes use more than `mesh_budget` bytes. */
+    size_t memory_budget;
+    size_t resident_bytes;
+    size_t mesh_budget;
+    size_t resident_mesh_bytes;
+    size_t evicted_chunk_count;
+
+    /* Set up by world_start_generation_workers(). Chunks that aren't saved are then generated on
+     * the pool's threads, and are in `generating_chunks` until an update picks them up from
+     * `generated_chunks`. At most `max_generation_jobs` chunks are generated at once, so the
+     * queue keeps up with the center moving. */
+    bool has_generation_workers;
+    Thread_Pool generation_pool;
+    size_t max_generation_jobs;
+    Chunk_Map generating_chunks;
+
+    Mutex generated_mutex;
+    Chunk **generated_chunks;
+    size_t generated_chunk_count;
+    size_t generated_chunk_capacity;
 
-    Chunk *dirty_list[WORLD_VOLUME];
-    size_t dirty_list_count;
+    /* Advanced on every world_update_loaded_chunks() call, see Chunk.last_access. */
+    uint64_t tick;
+
+    /* The chunks outside the load radius as of the last time the center moved, least recently
+     * used first. Chunks before `eviction_cursor` have already been evicted. */
+    Chunk **eviction_list;
+    size_t eviction_list_count;
+    size_t eviction_list_capacity;
+    size_t eviction_cursor;
+
+    /* Chunks edited by the current batch of edits, and their neighbors, so each is marked dirty
+     * once when the batch is done. */
+    Chunk **edit_batch;
+    size_t edit_batch_count;
+    size_t edit_batch_capacity;
+
+    /* Binary min-heap of the chunks waiting to be meshed, keyed by squared distance to
+     * `dirty_center`. Keys are only recomputed, and the heap rebuilt, when a pop asks for a
+     * different center. */
+    Dirty_Entry *dirty_queue;
+    size_t dirty_queue_count;
+    size_t dirty_queue_capacity;
+    iVec3 dirty_center;
+
+    /* Source of chunk versions. Versions are unique across the whole world, so a chunk that is
+     * unloaded and later loaded again can't be mistaken for its previous self. */
+    uint32_t next_version;
 } World;
 
+bool world_create(World *world, int load_radius, int vertical_load_radius,
+                  Chunk_Generate_Fn generate, Chunk_Unload_Fn on_unload);
+
+/* Unloads every chunk, saving the modified ones. Waits for chunks still being generated. */
+void world_destroy(World *world);
+
+/* Moves chunk generation onto `thread_count` worker threads. Updates then only start generating
+ * missing chunks, nearest first, and add them to the world and the dirty queue in later updates as
+ * they finish. Chunks loaded from storage are still loaded within the update. Call before the
+ * first update. */
+bool world_start_generation_workers(World *world, size_t thread_count);
+
+/* Returns true until every chunk in the load radius is loaded or being generated, and every
+ * chunk being generated has been added to the world. */
+bool world_is_loading(const World *world);
+
+/* Saves every modified chunk that is loaded, waits for the region files to reach the disk, and
+ * then empties the journal. Returns false if any of them failed to save. */
+bool world_save(World *world);
+
+/* Applies the edits left in the journal by a crash to the saved chunks, then empties the journal.
+ * Call before any chunks are loaded. */
+bool world_replay_journal(World *world);
+
+/* Loads chunks around the center chunk coordinate, and evicts chunks that are out of range while
+ * the world is over its memory budget. */
+void world_update_loaded_chunks(World *world, iVec3 center_chunk_coord);
+
+/* Returns NULL if the chunk isn't loaded. Counts as a use of the chunk. */
 Chunk *world_get_chunk(World *world, iVec3 chunk_coord);
 
+/* Returns true if the chunk is within the load radius of the current center. */
+bool world_is_chunk_in_range(const World *world, const Chunk *chunk);
+
+/* Recounts the memory used by the chunk after its mesh was replaced. */
+void world_update_chunk_memory(World *world, Chunk *chunk);
+
 void world_push_dirty_chunk(World *world, Chunk *chunk);
+
+/* Returns the dirty chunk closest to the given chunk coordinate, or NULL if there are none. */
 Chunk *world_pop_dirty_chunk(World *world, iVec3 player_position);
 
+/* Blocks in chunks that aren't loaded read as BLOCK_DIRT, and setting them does nothing. */
 Block_Type world_get_block(const World *world, iVec3 position);
 void world_set_block(World *world, iVec3 position, Block_Type new_block);
 
+/* Batched edits. Boxes go from `min` (inclusive) to `max` (exclusive). Blocks in chunks that
+ * aren't loaded are left alone. Each edited chunk and each neighbor whose mesh the edits reach is
+ * marked dirty once per call. Returns the number of chunks whose blocks changed. */
+size_t world_fill_box(World *world, iVec3 min, iVec3 max, Block_Type type);
+size_t world_replace_in_box(World *world, iVec3 min, iVec3 max, Block_Type from, Block_Type to);
+size_t world_set_blocks(World *world, const iVec3 *positions, const Block_Type *types,
+                        size_t count);
+
+/* Fills the padded block box used by the mesher: the chunk itself plus a one block shell taken
+ * from its 26 neighbors. */
+void world_get_meshing_data(const World *world, iVec3 chunk_coord, struct Meshing_Data *data);
+
+/* Snapshots the chunk and its loaded neighbors, see chunk_snapshot(). This only copies a few
+ * hundred bytes per chunk, so it is much cheaper than gathering the meshing data. The snapshots
+ * must be released with world_release_neighborhood(), which can happen on any thread. */
+void world_snapshot_neighborhood(const World *world, iVec3 chunk_coord,
+                                 Chunk_Neighborhood *neighborhood);
+void world_release_neighborhood(Chunk_Neighborhood *neighborhood);
+
+/* Like world_get_meshing_data(), but from the snapshots. Safe on any thread. */
+void world_get_neighborhood_meshing_data(const Chunk_Neighborhood *neighborhood,
+                                         struct Meshing_Data *data);
+
+/* Returns true if meshing the chunk can't produce any faces, because it is entirely air, or
+ * entirely opaque and enclosed by opaque neighbor faces. */
+bool world_is_chunk_mesh_empty(const World *world, const Chunk *chunk);
+
 #endif /* WORLD_H */